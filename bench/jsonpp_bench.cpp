@@ -0,0 +1,239 @@
+#include <jsonpp/json.hpp>
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#if defined(JSONPP_BENCH_HAVE_NLOHMANN)
+#include <nlohmann/json.hpp>
+#endif
+
+#if defined(JSONPP_BENCH_HAVE_RAPIDJSON)
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#endif
+
+// Every heap allocation made by the process goes through these, so the
+// benchmarks can report allocations per document.
+#if defined(__GNUC__) && !defined(__clang__)
+// GCC pairs the inlined free() with the replaced operator new and warns.
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace {
+    std::atomic<size_t> g_allocations{ 0 };
+}
+
+auto operator new(size_t size) -> void* {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+auto operator new(size_t size, std::align_val_t align) -> void* {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    const auto alignment = static_cast<size_t>(align);
+    if (void* p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+auto operator new[](size_t size) -> void* {
+    return operator new(size);
+}
+
+auto operator delete(void* p) noexcept -> void {
+    std::free(p);
+}
+
+auto operator delete(void* p, size_t) noexcept -> void { operator delete(p); }
+auto operator delete(void* p, std::align_val_t) noexcept -> void { operator delete(p); }
+auto operator delete(void* p, size_t, std::align_val_t) noexcept -> void { operator delete(p); }
+auto operator delete[](void* p) noexcept -> void { operator delete(p); }
+auto operator delete[](void* p, size_t) noexcept -> void { operator delete(p); }
+
+namespace {
+
+    struct corpus {
+        std::string name;
+        std::string text;
+    };
+
+    [[nodiscard]] auto data_directory() -> std::filesystem::path {
+        if (const char* dir = std::getenv("JSONPP_BENCH_DATA")) {
+            return dir;
+        }
+        return JSONPP_BENCH_DEFAULT_DATA_DIR;
+    }
+
+    [[nodiscard]] auto read_file(const std::filesystem::path& path) -> std::string {
+        std::ifstream file{ path, std::ios::binary };
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    [[nodiscard]] auto deep_nesting(size_t depth) -> std::string {
+        std::string text;
+        for (size_t i = 0; i < depth; ++i) {
+            text += i % 2 == 0 ? "{\"k\":" : "[";
+        }
+        text += "0";
+        for (size_t i = depth; i-- > 0;) {
+            text += i % 2 == 0 ? "}" : "]";
+        }
+        return text;
+    }
+
+    [[nodiscard]] auto huge_array(size_t count) -> std::string {
+        std::string text = "[";
+        for (size_t i = 0; i < count; ++i) {
+            if (i != 0) {
+                text += ',';
+            }
+            switch (i % 4) {
+                case 0: text += std::to_string(i); break;
+                case 1: text += std::to_string(static_cast<double>(i) / 7.0); break;
+                case 2: text += "\"item-" + std::to_string(i) + "\""; break;
+                default: text += i % 8 == 3 ? "true" : "null"; break;
+            }
+        }
+        text += "]";
+        return text;
+    }
+
+    [[nodiscard]] auto load_corpora() -> std::vector<corpus> {
+        std::vector<corpus> result;
+        for (const char* file : { "twitter.json", "canada.json", "citm_catalog.json", "gsoc-2018.json" }) {
+            const auto path = data_directory() / file;
+            if (std::filesystem::exists(path)) {
+                result.push_back({ std::filesystem::path{ file }.stem().string(), read_file(path) });
+            }
+        }
+        result.push_back({ "deep_nesting", deep_nesting(1000) });
+        result.push_back({ "huge_array", huge_array(1'000'000) });
+        return result;
+    }
+
+    auto report(benchmark::State& state, size_t bytes, size_t allocations) -> void {
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+        state.counters["allocs/doc"] = benchmark::Counter(
+            static_cast<double>(allocations) / static_cast<double>(std::max<benchmark::IterationCount>(state.iterations(), 1)));
+#if defined(__unix__) || defined(__APPLE__)
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+        state.counters["peak_rss_mb"] = static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0);
+#else
+        state.counters["peak_rss_mb"] = static_cast<double>(usage.ru_maxrss) / 1024.0;
+#endif
+#endif
+    }
+
+    // Runs fn once per iteration and reports throughput over `text`.
+    template <typename Fn>
+    auto measure(benchmark::State& state, const std::string& text, Fn&& fn) -> void {
+        const size_t before = g_allocations.load(std::memory_order_relaxed);
+        for (auto _ : state) {
+            fn();
+        }
+        report(state, text.size(), g_allocations.load(std::memory_order_relaxed) - before);
+    }
+
+    auto register_corpus(const corpus& c) -> void {
+        const std::string& text = c.text;
+
+        benchmark::RegisterBenchmark(("parse/" + c.name).c_str(), [&text](benchmark::State& state) {
+            measure(state, text, [&] { benchmark::DoNotOptimize(jsonpp::parse(text)); });
+        });
+
+        benchmark::RegisterBenchmark(("parse_document/" + c.name).c_str(), [&text](benchmark::State& state) {
+            measure(state, text, [&] { benchmark::DoNotOptimize(jsonpp::parse_document(text)); });
+        });
+
+        benchmark::RegisterBenchmark(("parse_view/" + c.name).c_str(), [&text](benchmark::State& state) {
+            measure(state, text, [&] { benchmark::DoNotOptimize(jsonpp::parse_view(text)); });
+        });
+
+        benchmark::RegisterBenchmark(("to_string/" + c.name).c_str(), [&text](benchmark::State& state) {
+            const auto doc = jsonpp::parse(text);
+            const auto output = jsonpp::to_string(doc);
+            measure(state, output, [&] { benchmark::DoNotOptimize(jsonpp::to_string(doc)); });
+        });
+
+        benchmark::RegisterBenchmark(("to_string_pretty/" + c.name).c_str(), [&text](benchmark::State& state) {
+            const auto doc = jsonpp::parse(text);
+            const auto output = jsonpp::to_string(doc, true);
+            measure(state, output, [&] { benchmark::DoNotOptimize(jsonpp::to_string(doc, true)); });
+        });
+
+#if defined(JSONPP_BENCH_HAVE_NLOHMANN)
+        benchmark::RegisterBenchmark(("nlohmann_parse/" + c.name).c_str(), [&text](benchmark::State& state) {
+            measure(state, text, [&] { benchmark::DoNotOptimize(nlohmann::json::parse(text)); });
+        });
+
+        benchmark::RegisterBenchmark(("nlohmann_dump/" + c.name).c_str(), [&text](benchmark::State& state) {
+            const auto doc = nlohmann::json::parse(text);
+            const auto output = doc.dump();
+            measure(state, output, [&] { benchmark::DoNotOptimize(doc.dump()); });
+        });
+#endif
+
+#if defined(JSONPP_BENCH_HAVE_RAPIDJSON)
+        benchmark::RegisterBenchmark(("rapidjson_parse/" + c.name).c_str(), [&text](benchmark::State& state) {
+            measure(state, text, [&] {
+                rapidjson::Document doc;
+                doc.Parse(text.data(), text.size());
+                benchmark::DoNotOptimize(doc.HasParseError());
+            });
+        });
+
+        benchmark::RegisterBenchmark(("rapidjson_write/" + c.name).c_str(), [&text](benchmark::State& state) {
+            rapidjson::Document doc;
+            doc.Parse(text.data(), text.size());
+            rapidjson::StringBuffer sizing;
+            rapidjson::Writer<rapidjson::StringBuffer> sizing_writer{ sizing };
+            doc.Accept(sizing_writer);
+            const std::string output{ sizing.GetString(), sizing.GetSize() };
+            measure(state, output, [&] {
+                rapidjson::StringBuffer buffer;
+                rapidjson::Writer<rapidjson::StringBuffer> writer{ buffer };
+                doc.Accept(writer);
+                benchmark::DoNotOptimize(buffer.GetSize());
+            });
+        });
+#endif
+    }
+
+}
+
+auto main(int argc, char** argv) -> int {
+    // Kept alive for the whole run; the registered benchmarks refer to it.
+    static const auto corpora = load_corpora();
+    for (const auto& c : corpora) {
+        register_corpus(c);
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -1,9 +1,28 @@
 #pragma once
 
+#include <expected>
+#include <functional>
+#include <vector>
 #include "json_value.hpp"
 #include "json_parser.hpp"
 #include "json_serializer.hpp"
+#include "json_sink.hpp"
+#include "json_writer.hpp"
 #include "json_exception.hpp"
+#include "json_document.hpp"
+#include "json_pool.hpp"
+#include "json_stats.hpp"
+#include "json_file.hpp"
+#include "json_stream.hpp"
+#include "json_ndjson.hpp"
+#include "json_lazy.hpp"
+#include "json_tape.hpp"
+#include "json_binary.hpp"
+#include "json_path.hpp"
+#include "json_patch.hpp"
+#include "json_split.hpp"
+#include "json_describe.hpp"
+#include "json_struct.hpp"
 
 namespace jsonpp {
 
@@ -12,9 +31,225 @@ namespace jsonpp {
         return p.parse();
     }
 
+    [[nodiscard]] inline auto parse(std::string_view json_text, const parse_options& options) -> value {
+        parser p{ json_text, options };
+        return p.parse();
+    }
+
+    // Non-throwing variant of parse(): malformed input comes back as a
+    // parse_error carrying the error code and byte offset.
+    [[nodiscard]] inline auto try_parse(std::string_view json_text, const parse_options& options = {})
+        -> std::expected<value, parse_error> {
+        parser p{ json_text, options };
+        return p.try_parse();
+    }
+
+    // Checks that json_text is one well-formed JSON value in valid UTF-8
+    // without building anything or allocating (unless options ask for a
+    // structural index).
+    [[nodiscard]] inline auto validate(std::string_view json_text, parse_options options = {})
+        -> std::expected<void, parse_error> {
+        options.validate_utf8 = true;
+        null_handler handler;
+        basic_parser<null_handler> p{ json_text, handler, options };
+        return p.try_parse();
+    }
+
+    namespace detail {
+
+        template <typename Callback>
+        struct top_level_key_handler {
+            static constexpr bool ignores_string_values = true;
+
+            Callback& callback;
+            size_t depth = 0;
+
+            auto on_null() noexcept -> void {}
+            auto on_bool(bool) noexcept -> void {}
+            auto on_int(integer_type) noexcept -> void {}
+            auto on_double(number_type) noexcept -> void {}
+            auto on_string(std::string_view) noexcept -> void {}
+            auto on_key(std::string_view key) -> void {
+                if (depth == 1) {
+                    std::invoke(callback, key);
+                }
+            }
+            auto start_object() noexcept -> void { ++depth; }
+            auto end_object(size_t) noexcept -> void { --depth; }
+            auto start_array() noexcept -> void { ++depth; }
+            auto end_array(size_t) noexcept -> void { --depth; }
+        };
+
+    }
+
+    // validate() that also passes each key of a top-level object to on_key,
+    // decoded, as it is met; on failure some keys may already have been
+    // reported. Only escaped keys longer than 15 bytes need memory.
+    template <std::invocable<std::string_view> Callback>
+    [[nodiscard]] inline auto validate(std::string_view json_text, Callback&& on_key, parse_options options = {})
+        -> std::expected<void, parse_error> {
+        options.validate_utf8 = true;
+        detail::top_level_key_handler<std::remove_reference_t<Callback>> handler{ on_key };
+        basic_parser<decltype(handler)> p{ json_text, handler, options };
+        return p.try_parse();
+    }
+
+    namespace detail {
+
+        // Combines hashes as the events arrive, the same way value::hash()
+        // does over the tree.
+        class hash_handler {
+        public:
+            [[nodiscard]] auto result() const noexcept -> uint64_t {
+                return result_;
+            }
+
+            auto on_null() -> void { deliver(hash_mix(hash_seed_null)); }
+            auto on_bool(bool b) -> void { deliver(hash_boolean(b)); }
+            auto on_int(integer_type i) -> void { deliver(hash_integer(i)); }
+            auto on_double(number_type n) -> void { deliver(hash_number(n)); }
+            auto on_string(std::string_view text) -> void { deliver(hash_string(text)); }
+            auto on_key(std::string_view key) -> void {
+                frames_.back().key = std::hash<std::string_view>{}(key);
+            }
+            auto start_object() -> void { frames_.push_back({ .object = true }); }
+            auto start_array() -> void { frames_.push_back({}); }
+            auto end_object(size_t) -> void { close(frames_.back().members.finish()); }
+            auto end_array(size_t) -> void { close(frames_.back().elements.finish()); }
+
+        private:
+            struct frame {
+                bool object = false;
+                size_t key = 0;
+                array_hash elements{};
+                object_hash members{};
+            };
+
+            std::vector<frame> frames_;
+            uint64_t result_ = 0;
+
+            auto deliver(uint64_t h) -> void {
+                if (frames_.empty()) {
+                    result_ = h;
+                } else if (frame& top = frames_.back(); top.object) {
+                    top.members.add(top.key, h);
+                } else {
+                    top.elements.add(h);
+                }
+            }
+
+            auto close(uint64_t h) -> void {
+                frames_.pop_back();
+                deliver(h);
+            }
+        };
+
+    }
+
+    // value::hash() of the text's value without building it, so texts that
+    // differ only in whitespace, member order or escapes hash alike. Every
+    // member of an object counts, where parse() keeps only the first of
+    // duplicated keys.
+    [[nodiscard]] inline auto hash_json(std::string_view json_text, const parse_options& options = {}) -> uint64_t {
+        detail::hash_handler handler;
+        basic_parser<detail::hash_handler> p{ json_text, handler, options };
+        p.parse();
+        return handler.result();
+    }
+
+    // Drives the handler with the events of json_text without building a tree.
+    template <sax_handler Handler>
+    inline auto parse_sax(std::string_view json_text, Handler& handler, const parse_options& options = {}) -> void {
+        basic_parser<Handler> p{ json_text, handler, options };
+        p.parse();
+    }
+
+    // Strings without escapes are returned as views into json_text, which
+    // must outlive the result.
+    [[nodiscard]] inline auto parse_view(std::string_view json_text) -> value {
+        parser p{ json_text, parse_options{ .borrow_strings = true } };
+        return p.parse();
+    }
+
+    [[nodiscard]] inline auto parse_tape(std::string_view json_text, const parse_options& options = {}) -> tape_document {
+        return tape_document{ json_text, options };
+    }
+
+    // Decodes straight into a JSONPP_DESCRIBE'd type without building a value.
+    template <described T>
+    [[nodiscard]] inline auto parse(std::string_view json_text, const parse_options& options = {}) -> T {
+        detail::struct_decoder decoder{ json_text, options };
+        return decoder.decode<T>();
+    }
+
+    [[nodiscard]] inline auto parse_document(std::string_view json_text, const parse_options& options = {}) -> document {
+        document doc{ json_text.size() * 2 };
+        parser p{ json_text, options, doc.resource() };
+        doc.root() = p.parse();
+        return doc;
+    }
+
+    // Parses a file through a memory mapping instead of reading it into a
+    // string. By default strings are borrowed from the mapping, which the
+    // returned document keeps alive.
+    [[nodiscard]] inline auto parse_file(
+        const std::filesystem::path& path,
+        const parse_options& options = { .borrow_strings = true }
+    ) -> file_document {
+        return file_document{ path, options };
+    }
+
 
     [[nodiscard]] inline auto to_string(const value& val, bool pretty = false) -> std::string {
         serializer s{ pretty };
         return s.serialize(val);
     }
+
+    // Appends to out instead of returning a new string, so a buffer that is
+    // cleared and reused keeps its capacity across calls.
+    template <output_buffer Buffer>
+    inline auto to_string(const value& val, Buffer& out, bool pretty = false) -> void {
+        serializer s{ pretty };
+        s.serialize_to(val, out);
+    }
+
+    template <described T>
+    [[nodiscard]] inline auto to_string(const T& object, bool pretty = false) -> std::string {
+        serializer s{ pretty };
+        return s.serialize(object);
+    }
+
+    template <described T, output_buffer Buffer>
+    inline auto to_string(const T& object, Buffer& out, bool pretty = false) -> void {
+        serializer s{ pretty };
+        s.serialize_to(object, out);
+    }
+
+    // Streams the JSON text of val into sink through a buffer of
+    // buffer_size bytes, which bounds the memory used however large val is.
+    template <output_sink Sink>
+    inline auto to_sink(
+        const value& val,
+        Sink& sink,
+        bool pretty = false,
+        size_t buffer_size = sink_buffer<Sink>::default_capacity
+    ) -> void {
+        sink_buffer<Sink> out{ sink, buffer_size };
+        serializer s{ pretty };
+        s.serialize_to(val, out);
+        out.flush();
+    }
+
+    template <described T, output_sink Sink>
+    inline auto to_sink(
+        const T& object,
+        Sink& sink,
+        bool pretty = false,
+        size_t buffer_size = sink_buffer<Sink>::default_capacity
+    ) -> void {
+        sink_buffer<Sink> out{ sink, buffer_size };
+        serializer s{ pretty };
+        s.serialize_to(object, out);
+        out.flush();
+    }
 }
@@ -0,0 +1,988 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <bit>
+#include <algorithm>
+#include <limits>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "json_value.hpp"
+#include "json_parser.hpp"
+#include "json_tape.hpp"
+#include "json_exception.hpp"
+
+namespace jsonpp {
+
+namespace detail {
+
+    // Appends big-endian bytes to a string.
+    class byte_sink {
+    public:
+        explicit byte_sink(std::string& out) noexcept
+            : out_{ out } {}
+
+        auto put(uint8_t byte) -> void {
+            out_.push_back(static_cast<char>(byte));
+        }
+
+        template <std::unsigned_integral T>
+        auto put_be(T bits) -> void {
+            if constexpr (std::endian::native == std::endian::little) {
+                bits = std::byteswap(bits);
+            }
+            out_.append(reinterpret_cast<const char*>(&bits), sizeof(bits));
+        }
+
+        auto append(std::string_view bytes) -> void {
+            out_.append(bytes);
+        }
+
+    private:
+        std::string& out_;
+    };
+
+    // Bounds-checked cursor over binary input; every failure is a
+    // parse_exception at the offending byte offset.
+    class byte_source {
+    public:
+        byte_source(std::string_view input, size_t max_depth) noexcept
+            : input_{ input }, max_depth_{ max_depth } {}
+
+        [[noreturn]] auto fail(const char* message, size_t offset) const -> void {
+            throw parse_exception{ message, offset };
+        }
+
+        [[nodiscard]] auto position() const noexcept -> size_t {
+            return position_;
+        }
+
+        [[nodiscard]] auto remaining() const noexcept -> size_t {
+            return input_.size() - position_;
+        }
+
+        [[nodiscard]] auto peek() const -> uint8_t {
+            if (position_ >= input_.size()) {
+                fail("Unexpected end of binary input", position_);
+            }
+            return static_cast<uint8_t>(input_[position_]);
+        }
+
+        [[nodiscard]] auto byte() -> uint8_t {
+            const uint8_t result = peek();
+            ++position_;
+            return result;
+        }
+
+        [[nodiscard]] auto take(uint64_t count) -> std::string_view {
+            if (count > remaining()) {
+                fail("Unexpected end of binary input", input_.size());
+            }
+            const auto result = input_.substr(position_, static_cast<size_t>(count));
+            position_ += static_cast<size_t>(count);
+            return result;
+        }
+
+        template <std::unsigned_integral T>
+        [[nodiscard]] auto read_be() -> T {
+            T bits;
+            std::memcpy(&bits, take(sizeof(T)).data(), sizeof(T));
+            if constexpr (std::endian::native == std::endian::little) {
+                bits = std::byteswap(bits);
+            }
+            return bits;
+        }
+
+        // Rejects element counts that could not possibly fit in the rest of
+        // the input, before anything loops over them.
+        auto check_count(uint64_t count, size_t min_item_size, size_t offset) const -> void {
+            if (count > remaining() / min_item_size) {
+                fail("Container length exceeds binary input", offset);
+            }
+        }
+
+        // The readers recurse once per array or map, so nesting beyond
+        // parse_options::max_depth is rejected as it is in text.
+        auto descend(size_t offset) -> void {
+            if (depth_ == max_depth_) {
+                throw parse_exception{ parse_error{ .code = parse_errc::depth_exceeded, .offset = offset } };
+            }
+            ++depth_;
+        }
+
+        auto ascend() noexcept -> void {
+            --depth_;
+        }
+
+        auto finish() const -> void {
+            if (position_ != input_.size()) {
+                fail("Unexpected bytes after binary value", position_);
+            }
+        }
+
+    private:
+        std::string_view input_;
+        size_t position_ = 0;
+        size_t max_depth_;
+        size_t depth_ = 0;
+    };
+
+    // True when d survives a round trip through float, so it can be written
+    // in four bytes instead of eight.
+    [[nodiscard]] inline auto fits_float(number_type d) noexcept -> bool {
+        if (std::isinf(d)) {
+            return true;
+        }
+        return std::fabs(d) <= std::numeric_limits<float>::max() &&
+               static_cast<number_type>(static_cast<float>(d)) == d;
+    }
+
+    // Integers beyond int64_t decode as doubles, as big_integer_mode::as_double
+    // would for text.
+    template <sax_handler Handler>
+    auto report_unsigned(Handler& handler, uint64_t n) -> void {
+        if (n <= static_cast<uint64_t>(std::numeric_limits<integer_type>::max())) {
+            handler.on_int(static_cast<integer_type>(n));
+        } else {
+            handler.on_double(static_cast<number_type>(n));
+        }
+    }
+
+    // Walks a value or tape_value, both of which share the accessors used here.
+    template <typename Writer, typename Tree>
+    auto encode_tree(Writer& writer, const Tree& node) -> void {
+        switch (node.type()) {
+            case value_type::null: writer.null(); return;
+            case value_type::boolean: writer.boolean(node.as_boolean()); return;
+            case value_type::integer: writer.integer(node.as_integer()); return;
+            case value_type::number: writer.number(node.as_number()); return;
+            case value_type::string: writer.string(node.as_string()); return;
+            case value_type::array:
+                writer.begin_array(node.size());
+                for (const auto& element : node.as_array()) {
+                    encode_tree(writer, element);
+                }
+                return;
+            case value_type::object:
+                writer.begin_object(node.size());
+                for (const auto& [key, member] : node.as_object()) {
+                    writer.string(std::string_view{ key });
+                    encode_tree(writer, member);
+                }
+                return;
+        }
+    }
+
+    // Replays a value tree as parser events.
+    template <sax_handler Handler>
+    auto replay(const value& node, Handler& handler) -> void {
+        switch (node.type()) {
+            case value_type::null: handler.on_null(); return;
+            case value_type::boolean: handler.on_bool(node.as_boolean()); return;
+            case value_type::integer: handler.on_int(node.as_integer()); return;
+            case value_type::number: handler.on_double(node.as_number()); return;
+            case value_type::string: handler.on_string(node.as_string()); return;
+            case value_type::array:
+                handler.start_array();
+                for (const auto& element : node.as_array()) {
+                    replay(element, handler);
+                }
+                handler.end_array(node.size());
+                return;
+            case value_type::object:
+                handler.start_object();
+                for (const auto& [key, member] : node.as_object()) {
+                    handler.on_key(key);
+                    replay(member, handler);
+                }
+                handler.end_object(node.size());
+                return;
+        }
+    }
+
+    // RFC 8949 encoder using the preferred (shortest) serialization.
+    class cbor_writer {
+    public:
+        explicit cbor_writer(std::string& out) noexcept
+            : out_{ out } {}
+
+        auto null() -> void { out_.put(0xf6); }
+        auto boolean(bool b) -> void { out_.put(b ? 0xf5 : 0xf4); }
+
+        auto integer(integer_type i) -> void {
+            // Negative n is encoded as -1 - n, which is ~n in two's complement.
+            if (i >= 0) {
+                head(0, static_cast<uint64_t>(i));
+            } else {
+                head(1, ~static_cast<uint64_t>(i));
+            }
+        }
+
+        auto number(number_type d) -> void {
+            if (fits_float(d)) {
+                out_.put(0xfa);
+                out_.put_be(std::bit_cast<uint32_t>(static_cast<float>(d)));
+            } else {
+                out_.put(0xfb);
+                out_.put_be(std::bit_cast<uint64_t>(d));
+            }
+        }
+
+        auto string(std::string_view text) -> void {
+            head(3, text.size());
+            out_.append(text);
+        }
+
+        auto begin_array(size_t count) -> void { head(4, count); }
+        auto begin_object(size_t count) -> void { head(5, count); }
+
+    private:
+        byte_sink out_;
+
+        auto head(uint8_t major, uint64_t argument) -> void {
+            const auto initial = static_cast<uint8_t>(major << 5);
+            if (argument < 24) {
+                out_.put(static_cast<uint8_t>(initial | argument));
+            } else if (argument <= UINT8_MAX) {
+                out_.put(initial | 24);
+                out_.put(static_cast<uint8_t>(argument));
+            } else if (argument <= UINT16_MAX) {
+                out_.put(initial | 25);
+                out_.put_be(static_cast<uint16_t>(argument));
+            } else if (argument <= UINT32_MAX) {
+                out_.put(initial | 26);
+                out_.put_be(static_cast<uint32_t>(argument));
+            } else {
+                out_.put(initial | 27);
+                out_.put_be(argument);
+            }
+        }
+    };
+
+    // MessagePack encoder choosing the smallest representation of each item.
+    class msgpack_writer {
+    public:
+        explicit msgpack_writer(std::string& out) noexcept
+            : out_{ out } {}
+
+        auto null() -> void { out_.put(0xc0); }
+        auto boolean(bool b) -> void { out_.put(b ? 0xc3 : 0xc2); }
+
+        auto integer(integer_type i) -> void {
+            if (i >= 0) {
+                const auto n = static_cast<uint64_t>(i);
+                if (n < 0x80) {
+                    out_.put(static_cast<uint8_t>(n));
+                } else if (n <= UINT8_MAX) {
+                    out_.put(0xcc);
+                    out_.put(static_cast<uint8_t>(n));
+                } else if (n <= UINT16_MAX) {
+                    out_.put(0xcd);
+                    out_.put_be(static_cast<uint16_t>(n));
+                } else if (n <= UINT32_MAX) {
+                    out_.put(0xce);
+                    out_.put_be(static_cast<uint32_t>(n));
+                } else {
+                    out_.put(0xcf);
+                    out_.put_be(n);
+                }
+            } else if (i >= -32) {
+                out_.put(static_cast<uint8_t>(i));
+            } else if (i >= INT8_MIN) {
+                out_.put(0xd0);
+                out_.put(static_cast<uint8_t>(i));
+            } else if (i >= INT16_MIN) {
+                out_.put(0xd1);
+                out_.put_be(static_cast<uint16_t>(i));
+            } else if (i >= INT32_MIN) {
+                out_.put(0xd2);
+                out_.put_be(static_cast<uint32_t>(i));
+            } else {
+                out_.put(0xd3);
+                out_.put_be(static_cast<uint64_t>(i));
+            }
+        }
+
+        auto number(number_type d) -> void {
+            if (fits_float(d)) {
+                out_.put(0xca);
+                out_.put_be(std::bit_cast<uint32_t>(static_cast<float>(d)));
+            } else {
+                out_.put(0xcb);
+                out_.put_be(std::bit_cast<uint64_t>(d));
+            }
+        }
+
+        auto string(std::string_view text) -> void {
+            const size_t size = text.size();
+            if (size < 32) {
+                out_.put(static_cast<uint8_t>(0xa0 | size));
+            } else if (size <= UINT8_MAX) {
+                out_.put(0xd9);
+                out_.put(static_cast<uint8_t>(size));
+            } else if (size <= UINT16_MAX) {
+                out_.put(0xda);
+                out_.put_be(static_cast<uint16_t>(size));
+            } else {
+                out_.put(0xdb);
+                out_.put_be(checked_length(size));
+            }
+            out_.append(text);
+        }
+
+        auto begin_array(size_t count) -> void { container(count, 0x90, 0xdc); }
+        auto begin_object(size_t count) -> void { container(count, 0x80, 0xde); }
+
+    private:
+        byte_sink out_;
+
+        [[nodiscard]] static auto checked_length(size_t size) -> uint32_t {
+            if (size > UINT32_MAX) {
+                throw json_exception{"Value too large for MessagePack"};
+            }
+            return static_cast<uint32_t>(size);
+        }
+
+        // fixarray/fixmap, then the 16- and 32-bit forms that follow marker16.
+        auto container(size_t count, uint8_t fix, uint8_t marker16) -> void {
+            if (count < 16) {
+                out_.put(static_cast<uint8_t>(fix | count));
+            } else if (count <= UINT16_MAX) {
+                out_.put(marker16);
+                out_.put_be(static_cast<uint16_t>(count));
+            } else {
+                out_.put(static_cast<uint8_t>(marker16 + 1));
+                out_.put_be(checked_length(count));
+            }
+        }
+    };
+
+}
+
+// Decodes one CBOR data item into parser events. Definite and indefinite
+// lengths, half/single/double floats and tags (whose content is kept) are
+// accepted; byte strings and non-string map keys have no JSON equivalent
+// and are rejected.
+template <sax_handler Handler>
+class basic_cbor_reader {
+public:
+    basic_cbor_reader(std::string_view input, Handler& handler, size_t max_depth = parse_options{}.max_depth) noexcept
+        : input_{ input, max_depth }, handler_{ handler } {}
+
+    auto read() -> void {
+        read_item();
+        input_.finish();
+    }
+
+private:
+    static constexpr uint8_t indefinite = 31;
+    static constexpr uint8_t break_code = 0xff;
+
+    detail::byte_source input_;
+    Handler& handler_;
+    std::string scratch_;
+
+    auto argument(uint8_t info, size_t offset) -> uint64_t {
+        switch (info) {
+            case 24: return input_.byte();
+            case 25: return input_.read_be<uint16_t>();
+            case 26: return input_.read_be<uint32_t>();
+            case 27: return input_.read_be<uint64_t>();
+            default:
+                if (info < 24) {
+                    return info;
+                }
+                input_.fail("Invalid CBOR additional information", offset);
+        }
+    }
+
+    [[nodiscard]] auto at_break() -> bool {
+        if (input_.peek() == break_code) {
+            (void)input_.byte();
+            return true;
+        }
+        return false;
+    }
+
+    // Indefinite-length strings are joined in the scratch buffer; the view is
+    // valid until the next string is read.
+    [[nodiscard]] auto read_text(uint8_t info, size_t offset) -> std::string_view {
+        if (info != indefinite) {
+            return input_.take(argument(info, offset));
+        }
+        scratch_.clear();
+        while (!at_break()) {
+            const size_t chunk_offset = input_.position();
+            const uint8_t initial = input_.byte();
+            if (initial >> 5 != 3 || (initial & 0x1f) == indefinite) {
+                input_.fail("Invalid chunk in indefinite-length CBOR string", chunk_offset);
+            }
+            scratch_.append(input_.take(argument(initial & 0x1f, chunk_offset)));
+        }
+        return scratch_;
+    }
+
+    auto read_key() -> void {
+        const size_t offset = input_.position();
+        const uint8_t initial = input_.byte();
+        if (initial >> 5 != 3) {
+            input_.fail("CBOR map keys must be text strings", offset);
+        }
+        handler_.on_key(read_text(initial & 0x1f, offset));
+    }
+
+    auto read_item() -> void {
+        size_t offset = input_.position();
+        uint8_t initial = input_.byte();
+        // Tags are skipped in a loop, so a chain of them costs no recursion.
+        while (initial >> 5 == 6) {
+            (void)argument(initial & 0x1f, offset);
+            offset = input_.position();
+            initial = input_.byte();
+        }
+        const uint8_t info = initial & 0x1f;
+
+        switch (initial >> 5) {
+            case 0:
+                detail::report_unsigned(handler_, argument(info, offset));
+                return;
+            case 1: {
+                const uint64_t n = argument(info, offset);
+                if (n <= static_cast<uint64_t>(std::numeric_limits<integer_type>::max())) {
+                    handler_.on_int(-1 - static_cast<integer_type>(n));
+                } else {
+                    handler_.on_double(-1.0 - static_cast<number_type>(n));
+                }
+                return;
+            }
+            case 2:
+                input_.fail("CBOR byte strings have no JSON equivalent", offset);
+            case 3:
+                handler_.on_string(read_text(info, offset));
+                return;
+            case 4:
+                read_array(info, offset);
+                return;
+            case 5:
+                read_map(info, offset);
+                return;
+            default:
+                read_simple(info, offset);
+                return;
+        }
+    }
+
+    auto read_array(uint8_t info, size_t offset) -> void {
+        input_.descend(offset);
+        handler_.start_array();
+        uint64_t count = 0;
+        if (info == indefinite) {
+            for (; !at_break(); ++count) {
+                read_item();
+            }
+        } else {
+            count = argument(info, offset);
+            input_.check_count(count, 1, offset);
+            for (uint64_t i = 0; i < count; ++i) {
+                read_item();
+            }
+        }
+        handler_.end_array(static_cast<size_t>(count));
+        input_.ascend();
+    }
+
+    auto read_map(uint8_t info, size_t offset) -> void {
+        input_.descend(offset);
+        handler_.start_object();
+        uint64_t count = 0;
+        if (info == indefinite) {
+            for (; !at_break(); ++count) {
+                read_key();
+                read_item();
+            }
+        } else {
+            count = argument(info, offset);
+            input_.check_count(count, 2, offset);
+            for (uint64_t i = 0; i < count; ++i) {
+                read_key();
+                read_item();
+            }
+        }
+        handler_.end_object(static_cast<size_t>(count));
+        input_.ascend();
+    }
+
+    auto read_simple(uint8_t info, size_t offset) -> void {
+        switch (info) {
+            case 20: handler_.on_bool(false); return;
+            case 21: handler_.on_bool(true); return;
+            case 22:
+            case 23: handler_.on_null(); return;
+            case 25: handler_.on_double(half_to_double(input_.read_be<uint16_t>())); return;
+            case 26: handler_.on_double(std::bit_cast<float>(input_.read_be<uint32_t>())); return;
+            case 27: handler_.on_double(std::bit_cast<number_type>(input_.read_be<uint64_t>())); return;
+            default: input_.fail("Unsupported CBOR simple value", offset);
+        }
+    }
+
+    [[nodiscard]] static auto half_to_double(uint16_t half) noexcept -> number_type {
+        const int exponent = (half >> 10) & 0x1f;
+        const int mantissa = half & 0x3ff;
+        number_type magnitude;
+        if (exponent == 0) {
+            magnitude = std::ldexp(mantissa, -24);
+        } else if (exponent == 31) {
+            magnitude = mantissa == 0 ? std::numeric_limits<number_type>::infinity()
+                                      : std::numeric_limits<number_type>::quiet_NaN();
+        } else {
+            magnitude = std::ldexp(mantissa + 1024, exponent - 25);
+        }
+        return (half & 0x8000) != 0 ? -magnitude : magnitude;
+    }
+};
+
+// Decodes one MessagePack object into parser events. Binary and extension
+// types have no JSON equivalent and are rejected, as are non-string keys.
+template <sax_handler Handler>
+class basic_msgpack_reader {
+public:
+    basic_msgpack_reader(std::string_view input, Handler& handler, size_t max_depth = parse_options{}.max_depth) noexcept
+        : input_{ input, max_depth }, handler_{ handler } {}
+
+    auto read() -> void {
+        read_item();
+        input_.finish();
+    }
+
+private:
+    detail::byte_source input_;
+    Handler& handler_;
+
+    // Length of a string whose marker is byte, or false if it is not one.
+    [[nodiscard]] auto string_length(uint8_t byte, uint64_t& length) -> bool {
+        if (byte >= 0xa0 && byte <= 0xbf) {
+            length = byte & 0x1f;
+        } else if (byte == 0xd9) {
+            length = input_.byte();
+        } else if (byte == 0xda) {
+            length = input_.read_be<uint16_t>();
+        } else if (byte == 0xdb) {
+            length = input_.read_be<uint32_t>();
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    auto read_item() -> void {
+        const size_t offset = input_.position();
+        const uint8_t byte = input_.byte();
+
+        if (byte < 0x80) {
+            handler_.on_int(byte);
+            return;
+        }
+        if (byte >= 0xe0) {
+            handler_.on_int(static_cast<int8_t>(byte));
+            return;
+        }
+        if (byte < 0x90) {
+            read_map(byte & 0x0f, offset);
+            return;
+        }
+        if (byte < 0xa0) {
+            read_array(byte & 0x0f, offset);
+            return;
+        }
+        if (uint64_t length; string_length(byte, length)) {
+            handler_.on_string(input_.take(length));
+            return;
+        }
+
+        switch (byte) {
+            case 0xc0: handler_.on_null(); return;
+            case 0xc2: handler_.on_bool(false); return;
+            case 0xc3: handler_.on_bool(true); return;
+            case 0xca: handler_.on_double(std::bit_cast<float>(input_.read_be<uint32_t>())); return;
+            case 0xcb: handler_.on_double(std::bit_cast<number_type>(input_.read_be<uint64_t>())); return;
+            case 0xcc: handler_.on_int(input_.byte()); return;
+            case 0xcd: handler_.on_int(input_.read_be<uint16_t>()); return;
+            case 0xce: handler_.on_int(input_.read_be<uint32_t>()); return;
+            case 0xcf: detail::report_unsigned(handler_, input_.read_be<uint64_t>()); return;
+            case 0xd0: handler_.on_int(static_cast<int8_t>(input_.byte())); return;
+            case 0xd1: handler_.on_int(static_cast<int16_t>(input_.read_be<uint16_t>())); return;
+            case 0xd2: handler_.on_int(static_cast<int32_t>(input_.read_be<uint32_t>())); return;
+            case 0xd3: handler_.on_int(static_cast<int64_t>(input_.read_be<uint64_t>())); return;
+            case 0xdc: read_array(input_.read_be<uint16_t>(), offset); return;
+            case 0xdd: read_array(input_.read_be<uint32_t>(), offset); return;
+            case 0xde: read_map(input_.read_be<uint16_t>(), offset); return;
+            case 0xdf: read_map(input_.read_be<uint32_t>(), offset); return;
+            case 0xc1: input_.fail("Invalid MessagePack byte", offset);
+            default: input_.fail("MessagePack binary and extension types have no JSON equivalent", offset);
+        }
+    }
+
+    auto read_array(uint64_t count, size_t offset) -> void {
+        input_.check_count(count, 1, offset);
+        input_.descend(offset);
+        handler_.start_array();
+        for (uint64_t i = 0; i < count; ++i) {
+            read_item();
+        }
+        handler_.end_array(static_cast<size_t>(count));
+        input_.ascend();
+    }
+
+    auto read_map(uint64_t count, size_t offset) -> void {
+        input_.check_count(count, 2, offset);
+        input_.descend(offset);
+        handler_.start_object();
+        for (uint64_t i = 0; i < count; ++i) {
+            const size_t key_offset = input_.position();
+            uint64_t length = 0;
+            if (!string_length(input_.byte(), length)) {
+                input_.fail("MessagePack map keys must be strings", key_offset);
+            }
+            handler_.on_key(input_.take(length));
+            read_item();
+        }
+        handler_.end_object(static_cast<size_t>(count));
+        input_.ascend();
+    }
+};
+
+namespace detail {
+
+    template <template <typename> typename Reader>
+    [[nodiscard]] auto decode_value(
+        std::string_view bytes,
+        const parse_options& options,
+        std::pmr::memory_resource* resource
+    ) -> value {
+        dom_builder builder{ bytes, resource, false };
+        Reader<dom_builder> reader{ bytes, builder, options.max_depth };
+        reader.read();
+        return builder.release();
+    }
+
+    template <template <typename> typename Reader>
+    [[nodiscard]] auto decode_tape(std::string_view bytes, const parse_options& options) -> tape_document {
+        std::vector<uint64_t> words;
+        std::string strings;
+        words.reserve(bytes.size() / 4 + 16);
+        tape_builder builder{ words, strings };
+        Reader<tape_builder> reader{ bytes, builder, options.max_depth };
+        reader.read();
+        return { std::move(words), std::move(strings) };
+    }
+
+}
+
+[[nodiscard]] inline auto to_cbor(const value& root) -> std::string {
+    std::string out;
+    detail::cbor_writer writer{ out };
+    detail::encode_tree(writer, root);
+    return out;
+}
+
+[[nodiscard]] inline auto to_cbor(const tape_value& root) -> std::string {
+    std::string out;
+    detail::cbor_writer writer{ out };
+    detail::encode_tree(writer, root);
+    return out;
+}
+
+[[nodiscard]] inline auto from_cbor(
+    std::string_view bytes,
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+) -> value {
+    return detail::decode_value<basic_cbor_reader>(bytes, {}, resource);
+}
+
+// Only max_depth applies to binary input.
+[[nodiscard]] inline auto from_cbor(
+    std::string_view bytes,
+    const parse_options& options,
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+) -> value {
+    return detail::decode_value<basic_cbor_reader>(bytes, options, resource);
+}
+
+[[nodiscard]] inline auto tape_from_cbor(std::string_view bytes, const parse_options& options = {}) -> tape_document {
+    return detail::decode_tape<basic_cbor_reader>(bytes, options);
+}
+
+[[nodiscard]] inline auto to_msgpack(const value& root) -> std::string {
+    std::string out;
+    detail::msgpack_writer writer{ out };
+    detail::encode_tree(writer, root);
+    return out;
+}
+
+[[nodiscard]] inline auto to_msgpack(const tape_value& root) -> std::string {
+    std::string out;
+    detail::msgpack_writer writer{ out };
+    detail::encode_tree(writer, root);
+    return out;
+}
+
+[[nodiscard]] inline auto from_msgpack(
+    std::string_view bytes,
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+) -> value {
+    return detail::decode_value<basic_msgpack_reader>(bytes, {}, resource);
+}
+
+// Only max_depth applies to binary input.
+[[nodiscard]] inline auto from_msgpack(
+    std::string_view bytes,
+    const parse_options& options,
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+) -> value {
+    return detail::decode_value<basic_msgpack_reader>(bytes, options, resource);
+}
+
+[[nodiscard]] inline auto tape_from_msgpack(std::string_view bytes, const parse_options& options = {}) -> tape_document {
+    return detail::decode_tape<basic_msgpack_reader>(bytes, options);
+}
+
+// Native binary tape: a 24-byte header followed by the tape words and then
+// the string buffer, all little-endian.
+//   0: "JSONPP" magic, format version, a reserved zero byte
+//   8: number of tape words
+//  16: size of the string buffer in bytes
+// The words start 8-byte aligned, so a buffer holding this format can be
+// navigated in place by binary_tape_view without decoding.
+namespace binary_tape {
+
+    inline constexpr std::string_view magic = "JSONPP";
+    inline constexpr uint8_t version = 1;
+    inline constexpr size_t header_size = 24;
+
+    struct layout {
+        size_t words;
+        size_t string_bytes;
+    };
+
+    [[nodiscard]] inline auto read_u64(const char* bytes) noexcept -> uint64_t {
+        uint64_t result;
+        std::memcpy(&result, bytes, sizeof(result));
+        if constexpr (std::endian::native == std::endian::big) {
+            result = std::byteswap(result);
+        }
+        return result;
+    }
+
+    // Walks every word once and rejects anything tape_value could read out
+    // of bounds: unknown tags, truncated numbers, string entries outside the
+    // string buffer, brackets whose skip indices do not match, and object
+    // members that do not start with a key. The root must span the tape.
+    inline auto check_words(const char* data, size_t words, size_t string_bytes) -> void {
+        const auto corrupt = [] { throw json_exception{"Binary tape is corrupt"}; };
+        const auto word_at = [data](size_t i) { return read_u64(data + i * sizeof(uint64_t)); };
+
+        // Open brackets, with whether the next word of an object is a key.
+        struct open_bracket {
+            size_t index;
+            size_t count;
+            bool expects_key;
+        };
+        std::vector<open_bracket> open;
+
+        size_t i = 0;
+        do {
+            const uint64_t word = word_at(i);
+            const tape_tag tag = tape::tag_of(word);
+            if (tag == tape_tag::end_array || tag == tape_tag::end_object) {
+                if (open.empty()) {
+                    corrupt();
+                }
+                const open_bracket closed = open.back();
+                const uint64_t start = word_at(closed.index);
+                const bool object = tape::tag_of(start) == tape_tag::start_object;
+                if (object != (tag == tape_tag::end_object) || (object && !closed.expects_key) ||
+                    tape::payload_of(word) != closed.index || (start & 0xFFFFFFFF) != i + 1) {
+                    corrupt();
+                }
+                const uint64_t count = (start >> 32) & tape::count_saturated;
+                if (count != std::min<uint64_t>(closed.count, tape::count_saturated)) {
+                    corrupt();
+                }
+                open.pop_back();
+                ++i;
+                continue;
+            }
+
+            const bool is_key = !open.empty() && open.back().expects_key;
+            if (is_key && tag != tape_tag::string) {
+                corrupt();
+            }
+            if (!open.empty()) {
+                open.back().expects_key = tape::tag_of(word_at(open.back().index)) == tape_tag::start_object && !is_key;
+                open.back().count += is_key ? 0 : 1;
+            }
+
+            switch (tag) {
+                case tape_tag::null:
+                case tape_tag::true_value:
+                case tape_tag::false_value:
+                    ++i;
+                    break;
+                case tape_tag::integer:
+                case tape_tag::number:
+                    if (i + 2 > words) {
+                        corrupt();
+                    }
+                    i += 2;
+                    break;
+                case tape_tag::string: {
+                    const uint64_t offset = tape::payload_of(word);
+                    if (offset > string_bytes || string_bytes - offset < sizeof(uint32_t)) {
+                        corrupt();
+                    }
+                    uint32_t length;
+                    std::memcpy(&length, data + words * sizeof(uint64_t) + offset, sizeof(length));
+                    if constexpr (std::endian::native == std::endian::big) {
+                        length = std::byteswap(length);
+                    }
+                    if (length > string_bytes - offset - sizeof(uint32_t)) {
+                        corrupt();
+                    }
+                    ++i;
+                    break;
+                }
+                case tape_tag::start_array:
+                case tape_tag::start_object:
+                    open.push_back({ i, 0, tag == tape_tag::start_object });
+                    ++i;
+                    break;
+                default:
+                    corrupt();
+            }
+        } while (!open.empty() && i < words);
+
+        if (!open.empty() || i != words) {
+            corrupt();
+        }
+    }
+
+    // Checks the header and sizes, then every word, so that a truncated,
+    // corrupt or hostile buffer is rejected before anything navigates it.
+    [[nodiscard]] inline auto check(std::string_view bytes) -> layout {
+        if (bytes.size() < header_size) {
+            throw json_exception{"Binary tape is truncated"};
+        }
+        if (bytes.substr(0, magic.size()) != magic || bytes[7] != 0) {
+            throw json_exception{"Not a jsonpp binary tape"};
+        }
+        if (static_cast<uint8_t>(bytes[6]) != version) {
+            throw json_exception{"Unsupported binary tape version"};
+        }
+        const uint64_t words = read_u64(bytes.data() + 8);
+        const uint64_t string_bytes = read_u64(bytes.data() + 16);
+        const size_t available = bytes.size() - header_size;
+        if (words == 0 || words > available / sizeof(uint64_t) ||
+            string_bytes > available - words * sizeof(uint64_t)) {
+            throw json_exception{"Binary tape is truncated"};
+        }
+        check_words(bytes.data() + header_size, static_cast<size_t>(words), static_cast<size_t>(string_bytes));
+        return { static_cast<size_t>(words), static_cast<size_t>(string_bytes) };
+    }
+
+}
+
+[[nodiscard]] inline auto to_binary_tape(const tape_document& document) -> std::string {
+    const auto words = document.tape();
+    const auto strings = document.strings();
+
+    std::string out;
+    out.reserve(binary_tape::header_size + words.size_bytes() + strings.size());
+    out.append(binary_tape::magic);
+    out.push_back(static_cast<char>(binary_tape::version));
+    out.push_back('\0');
+    for (const uint64_t field : { uint64_t{ words.size() }, uint64_t{ strings.size() } }) {
+        const uint64_t bits = std::endian::native == std::endian::big ? std::byteswap(field) : field;
+        out.append(reinterpret_cast<const char*>(&bits), sizeof(bits));
+    }
+    if constexpr (std::endian::native == std::endian::little) {
+        out.append(reinterpret_cast<const char*>(words.data()), words.size_bytes());
+    } else {
+        for (const uint64_t word : words) {
+            const uint64_t bits = std::byteswap(word);
+            out.append(reinterpret_cast<const char*>(&bits), sizeof(bits));
+        }
+    }
+    out.append(strings);
+    return out;
+}
+
+[[nodiscard]] inline auto to_binary_tape(const value& root) -> std::string {
+    std::vector<uint64_t> words;
+    std::string strings;
+    tape_builder builder{ words, strings };
+    detail::replay(root, builder);
+    return to_binary_tape(tape_document{ std::move(words), std::move(strings) });
+}
+
+// Copies a binary tape into a tape_document; works for any alignment and
+// byte order.
+[[nodiscard]] inline auto tape_from_binary(std::string_view bytes) -> tape_document {
+    const auto layout = binary_tape::check(bytes);
+    const char* data = bytes.data() + binary_tape::header_size;
+
+    std::vector<uint64_t> words(layout.words);
+    std::memcpy(words.data(), data, layout.words * sizeof(uint64_t));
+    if constexpr (std::endian::native == std::endian::big) {
+        for (uint64_t& word : words) {
+            word = std::byteswap(word);
+        }
+    }
+    std::string strings{ data + layout.words * sizeof(uint64_t), layout.string_bytes };
+    return { std::move(words), std::move(strings) };
+}
+
+// Reads a binary tape where it lies, such as in a mapped file or a received
+// buffer, with no decoding step. The buffer must be 8-byte aligned, the host
+// little-endian, and the bytes must outlive the view.
+class binary_tape_view {
+public:
+    binary_tape_view() noexcept = default;
+
+    explicit binary_tape_view(std::string_view bytes) {
+        if constexpr (std::endian::native != std::endian::little) {
+            throw json_exception{"Binary tapes can only be read in place on little-endian hosts"};
+        }
+        if (reinterpret_cast<uintptr_t>(bytes.data()) % alignof(uint64_t) != 0) {
+            throw json_exception{"Binary tape is not 8-byte aligned"};
+        }
+        const auto layout = binary_tape::check(bytes);
+        const char* data = bytes.data() + binary_tape::header_size;
+        words_ = { reinterpret_cast<const uint64_t*>(data), layout.words };
+        strings_ = { data + words_.size_bytes(), layout.string_bytes };
+    }
+
+    [[nodiscard]] auto root() const -> tape_value {
+        if (words_.empty()) {
+            throw json_exception{"Empty tape document"};
+        }
+        return { words_.data(), strings_.data(), 0 };
+    }
+
+    [[nodiscard]] auto tape() const noexcept -> std::span<const uint64_t> {
+        return words_;
+    }
+
+    [[nodiscard]] auto strings() const noexcept -> std::string_view {
+        return strings_;
+    }
+
+private:
+    std::span<const uint64_t> words_;
+    std::string_view strings_;
+};
+
+}
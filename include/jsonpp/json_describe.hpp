@@ -0,0 +1,151 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+// JSONPP_DESCRIBE(Type, member...) lists the public data members of Type that
+// map to JSON object members of the same name. Place it at namespace scope
+// next to Type; the descriptor is found through argument-dependent lookup.
+//
+//     struct point { double x; double y; };
+//     JSONPP_DESCRIBE(point, x, y)
+//
+// MSVC needs the conforming preprocessor (/Zc:preprocessor), which the
+// jsonpp_lib target enables.
+#define JSONPP_DESCRIBE(Type, ...)                                                            \
+    [[maybe_unused]] constexpr auto jsonpp_describe(const Type*) noexcept {                   \
+        return std::make_tuple(JSONPP_DETAIL_FOR_EACH(JSONPP_DETAIL_MEMBER, Type, __VA_ARGS__)); \
+    }
+
+#define JSONPP_DETAIL_MEMBER(Type, member) ::jsonpp::detail::describe_member(#member, &Type::member)
+
+#define JSONPP_DETAIL_PARENS ()
+#define JSONPP_DETAIL_EXPAND(...) JSONPP_DETAIL_EXPAND3(JSONPP_DETAIL_EXPAND3(JSONPP_DETAIL_EXPAND3(JSONPP_DETAIL_EXPAND3(__VA_ARGS__))))
+#define JSONPP_DETAIL_EXPAND3(...) JSONPP_DETAIL_EXPAND2(JSONPP_DETAIL_EXPAND2(JSONPP_DETAIL_EXPAND2(JSONPP_DETAIL_EXPAND2(__VA_ARGS__))))
+#define JSONPP_DETAIL_EXPAND2(...) JSONPP_DETAIL_EXPAND1(JSONPP_DETAIL_EXPAND1(JSONPP_DETAIL_EXPAND1(JSONPP_DETAIL_EXPAND1(__VA_ARGS__))))
+#define JSONPP_DETAIL_EXPAND1(...) __VA_ARGS__
+#define JSONPP_DETAIL_FOR_EACH(macro, Type, ...) \
+    __VA_OPT__(JSONPP_DETAIL_EXPAND(JSONPP_DETAIL_FOR_EACH_STEP(macro, Type, __VA_ARGS__)))
+#define JSONPP_DETAIL_FOR_EACH_STEP(macro, Type, member, ...) \
+    macro(Type, member) __VA_OPT__(, JSONPP_DETAIL_FOR_EACH_AGAIN JSONPP_DETAIL_PARENS (macro, Type, __VA_ARGS__))
+#define JSONPP_DETAIL_FOR_EACH_AGAIN() JSONPP_DETAIL_FOR_EACH_STEP
+
+namespace jsonpp {
+
+template <typename Class, typename Member>
+struct member_descriptor {
+    using member_type = Member;
+
+    std::string_view name;
+    Member Class::* pointer;
+};
+
+template <typename T>
+concept described = requires(const T* object) {
+    jsonpp_describe(object);
+};
+
+namespace detail {
+
+    template <typename Class, typename Member>
+    [[nodiscard]] constexpr auto describe_member(std::string_view name, Member Class::* pointer) noexcept
+        -> member_descriptor<Class, Member> {
+        return { name, pointer };
+    }
+
+    template <typename T>
+    inline constexpr bool is_optional_v = false;
+
+    template <typename T>
+    inline constexpr bool is_optional_v<std::optional<T>> = true;
+
+    // Packs the length and three sampled bytes of a key; a seed multiplies
+    // it into the table position.
+    [[nodiscard]] constexpr auto key_signature(std::string_view key) noexcept -> uint64_t {
+        uint64_t signature = key.size();
+        if (!key.empty()) {
+            signature |= uint64_t{ static_cast<unsigned char>(key.front()) } << 16;
+            signature |= uint64_t{ static_cast<unsigned char>(key[key.size() / 2]) } << 24;
+            signature |= uint64_t{ static_cast<unsigned char>(key.back()) } << 32;
+        }
+        return signature;
+    }
+
+    // Member names of a described type and a collision-free hash table over
+    // them, both computed at compile time. lookup() costs one multiply and
+    // one comparison; when no seed separates the names it scans instead.
+    template <described T>
+    struct field_table {
+        static constexpr auto fields = jsonpp_describe(static_cast<const T*>(nullptr));
+        static constexpr size_t size = std::tuple_size_v<decltype(fields)>;
+
+        static constexpr auto names = std::apply([](const auto&... field) {
+            return std::array<std::string_view, size>{ field.name... };
+        }, fields);
+
+        static constexpr int bits = [] {
+            int result = 0;
+            while ((size_t{ 1 } << result) < size * size && result < 12) {
+                ++result;
+            }
+            return result;
+        }();
+
+        static constexpr size_t slots = size_t{ 1 } << bits;
+
+        [[nodiscard]] static constexpr auto slot(std::string_view key, uint64_t seed) noexcept -> size_t {
+            return bits == 0 ? 0 : static_cast<size_t>((key_signature(key) * seed) >> (64 - bits));
+        }
+
+        static constexpr uint64_t seed = [] {
+            for (uint64_t attempt = 0; attempt < 256; ++attempt) {
+                const uint64_t candidate = (0x9E3779B97F4A7C15 + attempt * 0xBF58476D1CE4E5B9) | 1;
+                std::array<bool, slots> used{};
+                bool ok = true;
+                for (const auto name : names) {
+                    auto& taken = used[slot(name, candidate)];
+                    ok = ok && !taken;
+                    taken = true;
+                }
+                if (ok) {
+                    return candidate;
+                }
+            }
+            return uint64_t{ 0 };
+        }();
+
+        static constexpr auto table = [] {
+            std::array<uint16_t, slots> result{};
+            for (size_t i = 0; seed != 0 && i < size; ++i) {
+                result[slot(names[i], seed)] = static_cast<uint16_t>(i + 1);
+            }
+            return result;
+        }();
+
+        // Index of the member named key, or size when there is none.
+        [[nodiscard]] static constexpr auto lookup(std::string_view key) noexcept -> size_t {
+            if constexpr (size == 0) {
+                return 0;
+            } else {
+                if (seed == 0) {
+                    for (size_t i = 0; i < size; ++i) {
+                        if (names[i] == key) {
+                            return i;
+                        }
+                    }
+                    return size;
+                }
+                const size_t entry = table[slot(key, seed)];
+                return entry != 0 && names[entry - 1] == key ? entry - 1 : size;
+            }
+        }
+    };
+
+}
+
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <memory>
+#include <memory_resource>
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <optional>
+#include "json_value.hpp"
+
+namespace jsonpp {
+
+// Owns a monotonic arena holding every node, string and container of a
+// parsed tree. Destruction releases the arena in one step without walking the
+// tree, so anything stored through root() must be allocated from resource().
+class document {
+public:
+    static constexpr size_t min_initial_size = 4096;
+
+    explicit document(size_t initial_size = min_initial_size)
+        : arena_{ std::make_unique<arena>(std::max(initial_size, min_initial_size)) } {
+        create_root();
+    }
+
+    document(document&&) noexcept = default;
+    auto operator=(document&&) noexcept -> document& = default;
+
+    document(const document&) = delete;
+    auto operator=(const document&) -> document& = delete;
+
+    ~document() = default;
+
+    [[nodiscard]] auto root() const noexcept -> const value& {
+        return *root_;
+    }
+
+    [[nodiscard]] auto root() noexcept -> value& {
+        return *root_;
+    }
+
+    [[nodiscard]] auto resource() const noexcept -> std::pmr::memory_resource* {
+        return arena_->resource();
+    }
+
+    // Drops the tree and rewinds the arena so the document can hold the next
+    // one. If the last tree outgrew the first buffer, that buffer is enlarged
+    // to the size the arena reached, so a reused document settles at a single
+    // allocation; it is capped at max_retained, which also shrinks a buffer
+    // left large by an outlier.
+    auto clear(size_t max_retained = std::numeric_limits<size_t>::max()) -> void {
+        root_ = nullptr;
+        arena_->rewind(std::clamp(arena_->capacity(), min_initial_size, std::max(max_retained, min_initial_size)));
+        create_root();
+    }
+
+    // Bytes the arena currently holds.
+    [[nodiscard]] auto capacity() const noexcept -> size_t {
+        return arena_->capacity();
+    }
+
+private:
+    // A monotonic arena over one retained buffer. Chunks beyond the buffer
+    // come from the default resource through this class, which counts them.
+    class arena final : public std::pmr::memory_resource {
+    public:
+        explicit arena(size_t size) {
+            rewind(size);
+        }
+
+        [[nodiscard]] auto resource() noexcept -> std::pmr::memory_resource* {
+            return &*monotonic_;
+        }
+
+        [[nodiscard]] auto capacity() const noexcept -> size_t {
+            return size_ + overflow_;
+        }
+
+        auto rewind(size_t size) -> void {
+            monotonic_.reset();
+            if (size != size_) {
+                buffer_.reset();
+                buffer_ = std::make_unique_for_overwrite<std::byte[]>(size);
+                size_ = size;
+            }
+            monotonic_.emplace(buffer_.get(), size_, this);
+        }
+
+    private:
+        std::unique_ptr<std::byte[]> buffer_;
+        size_t size_ = 0;
+        size_t overflow_ = 0;
+        std::pmr::memory_resource* upstream_ = std::pmr::get_default_resource();
+        std::optional<std::pmr::monotonic_buffer_resource> monotonic_;
+
+        auto do_allocate(size_t bytes, size_t alignment) -> void* override {
+            void* storage = upstream_->allocate(bytes, alignment);
+            overflow_ += bytes;
+            return storage;
+        }
+
+        auto do_deallocate(void* storage, size_t bytes, size_t alignment) -> void override {
+            upstream_->deallocate(storage, bytes, alignment);
+            overflow_ -= bytes;
+        }
+
+        auto do_is_equal(const std::pmr::memory_resource& other) const noexcept -> bool override {
+            return this == &other;
+        }
+    };
+
+    std::unique_ptr<arena> arena_;
+    value* root_;
+
+    auto create_root() -> void {
+        void* storage = resource()->allocate(sizeof(value), alignof(value));
+        root_ = ::new (storage) value{};
+    }
+};
+
+}
@@ -4,9 +4,85 @@
 #include <string>
 #include <format>
 #include <source_location>
+#include <cstdint>
 
 namespace jsonpp {
 
+    enum class parse_errc : uint8_t {
+        unexpected_end,
+        trailing_characters,
+        unexpected_character,
+        expected_token,
+        invalid_null,
+        invalid_boolean,
+        invalid_number,
+        missing_fraction_digit,
+        missing_exponent_digit,
+        integer_overflow,
+        number_out_of_range,
+        unterminated_string,
+        unterminated_escape,
+        invalid_unicode_escape,
+        invalid_hex_digit,
+        invalid_escape,
+        control_character,
+        unterminated_array,
+        trailing_comma_in_array,
+        expected_array_separator,
+        expected_key,
+        unterminated_object,
+        trailing_comma_in_object,
+        expected_object_separator,
+        invalid_utf8,
+        depth_exceeded
+    };
+
+    // A parse failure as plain data: what went wrong and where. The text is
+    // only built when message() is called.
+    struct parse_error {
+        parse_errc code = parse_errc::unexpected_end;
+        size_t offset = 0;
+        // The offending byte, and for expected_token the byte wanted.
+        char found = '\0';
+        char expected = '\0';
+
+        [[nodiscard]] auto description() const -> std::string {
+            switch (code) {
+                case parse_errc::unexpected_end: return "Unexpected end of input";
+                case parse_errc::trailing_characters: return "Unexpected characters after JSON value";
+                case parse_errc::unexpected_character: return std::format("Unexpected character '{}'", found);
+                case parse_errc::expected_token: return std::format("Expected '{}', got '{}'", expected, found);
+                case parse_errc::invalid_null: return "Invalid null literal";
+                case parse_errc::invalid_boolean: return "Invalid boolean literal";
+                case parse_errc::invalid_number: return "Invalid number";
+                case parse_errc::missing_fraction_digit: return "Invalid number: expected digit after '.'";
+                case parse_errc::missing_exponent_digit: return "Invalid number: expected digit in exponent";
+                case parse_errc::integer_overflow: return "Failed to parse integer";
+                case parse_errc::number_out_of_range: return "Failed to parse number";
+                case parse_errc::unterminated_string: return "Unterminated string";
+                case parse_errc::unterminated_escape: return "Unterminated escape sequence";
+                case parse_errc::invalid_unicode_escape: return "Invalid unicode escape";
+                case parse_errc::invalid_hex_digit: return "Invalid hex digit in unicode escape";
+                case parse_errc::invalid_escape: return std::format("Invalid escape sequence '\\{}'", found);
+                case parse_errc::control_character: return "Unescaped control character in string";
+                case parse_errc::unterminated_array: return "Unterminated array";
+                case parse_errc::trailing_comma_in_array: return "Trailing comma in array";
+                case parse_errc::expected_array_separator: return std::format("Expected ',' or ']', got '{}'", found);
+                case parse_errc::expected_key: return "Expected string key in object";
+                case parse_errc::unterminated_object: return "Unterminated object";
+                case parse_errc::trailing_comma_in_object: return "Trailing comma in object";
+                case parse_errc::expected_object_separator: return std::format("Expected ',' or '}}', got '{}'", found);
+                case parse_errc::invalid_utf8: return "Invalid UTF-8 in string";
+                case parse_errc::depth_exceeded: return "Maximum nesting depth exceeded";
+            }
+            return "Invalid JSON";
+        }
+
+        [[nodiscard]] auto message() const -> std::string {
+            return std::format("{} at position {}", description(), offset);
+        }
+    };
+
     class json_exception : public std::runtime_error
     {
         public:
@@ -30,6 +106,12 @@ namespace jsonpp {
             position_{ position } {
         }
 
+        explicit parse_exception(
+            const parse_error& error,
+            std::source_location location = std::source_location::current()
+        ) : parse_exception{ error.description(), error.offset, location } {
+        }
+
         [[nodiscard]] auto position() const noexcept -> size_t {
             return position_;
         }
@@ -43,4 +125,11 @@ namespace jsonpp {
         using json_exception::json_exception;
     };
 
+    // A JSON Patch that is malformed, names a missing location or fails a
+    // "test" operation.
+    class patch_exception : public json_exception {
+    public:
+        using json_exception::json_exception;
+    };
+
 }
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+#include <algorithm>
+#include <format>
+#include "json_value.hpp"
+#include "json_parser.hpp"
+#include "json_document.hpp"
+#include "json_binary.hpp"
+#include "json_exception.hpp"
+
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace jsonpp {
+
+// Read-only memory mapping of a whole file. The pages are read in by the
+// kernel as the parser touches them, with a hint that access is sequential,
+// so no copy of the file is ever made. An empty file maps to an empty view.
+class mapped_file {
+public:
+    mapped_file() noexcept = default;
+
+    explicit mapped_file(const std::filesystem::path& path) {
+#if defined(_WIN32)
+        HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            fail(path, static_cast<int>(::GetLastError()));
+        }
+        LARGE_INTEGER size{};
+        if (!::GetFileSizeEx(file, &size)) {
+            const DWORD error = ::GetLastError();
+            ::CloseHandle(file);
+            fail(path, static_cast<int>(error));
+        }
+        size_ = static_cast<size_t>(size.QuadPart);
+        if (size_ != 0) {
+            HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            const DWORD error = ::GetLastError();
+            ::CloseHandle(file);
+            if (mapping == nullptr) {
+                fail(path, static_cast<int>(error));
+            }
+            // The view keeps the mapping object alive once both handles close.
+            data_ = static_cast<const char*>(::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            const DWORD view_error = ::GetLastError();
+            ::CloseHandle(mapping);
+            if (data_ == nullptr) {
+                fail(path, static_cast<int>(view_error));
+            }
+        } else {
+            ::CloseHandle(file);
+        }
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            fail(path, errno);
+        }
+        struct stat status{};
+        if (::fstat(fd, &status) != 0) {
+            const int error = errno;
+            ::close(fd);
+            fail(path, error);
+        }
+        size_ = static_cast<size_t>(status.st_size);
+        if (size_ != 0) {
+            void* mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            const int error = errno;
+            ::close(fd);
+            if (mapping == MAP_FAILED) {
+                fail(path, error);
+            }
+            ::madvise(mapping, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(mapping);
+        } else {
+            ::close(fd);
+        }
+#endif
+    }
+
+    mapped_file(mapped_file&& other) noexcept
+        : data_{ std::exchange(other.data_, nullptr) }, size_{ std::exchange(other.size_, 0) } {}
+
+    auto operator=(mapped_file&& other) noexcept -> mapped_file& {
+        if (this != &other) {
+            unmap();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+        }
+        return *this;
+    }
+
+    mapped_file(const mapped_file&) = delete;
+    auto operator=(const mapped_file&) -> mapped_file& = delete;
+
+    ~mapped_file() {
+        unmap();
+    }
+
+    [[nodiscard]] auto text() const noexcept -> std::string_view {
+        return { data_, data_ != nullptr ? size_ : 0 };
+    }
+
+    [[nodiscard]] auto size() const noexcept -> size_t {
+        return size_;
+    }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+
+    [[noreturn]] static auto fail(const std::filesystem::path& path, int error) -> void {
+        throw json_exception{
+            std::format("Cannot map file '{}': {}", path.string(), std::system_category().message(error))
+        };
+    }
+
+    auto unmap() noexcept -> void {
+        if (data_ == nullptr) {
+            return;
+        }
+#if defined(_WIN32)
+        ::UnmapViewOfFile(data_);
+#else
+        ::munmap(const_cast<char*>(data_), size_);
+#endif
+        data_ = nullptr;
+    }
+};
+
+// A document parsed straight from a mapped file. It owns both the mapping and
+// the arena, so borrowed strings in the tree stay valid for its lifetime.
+class file_document {
+public:
+    // The arena's first buffer is allocated up front, so it is sized from the
+    // file only up to this bound; larger trees grow the arena chunk by chunk
+    // as they are built.
+    static constexpr size_t max_initial_arena = size_t{ 64 } << 20;
+
+    explicit file_document(const std::filesystem::path& path, const parse_options& options = { .borrow_strings = true })
+        : file_{ path }, document_{ std::min(file_.size() / 2, max_initial_arena) } {
+        parser p{ file_.text(), options, document_.resource() };
+        document_.root() = p.parse();
+    }
+
+    [[nodiscard]] auto root() const noexcept -> const value& {
+        return document_.root();
+    }
+
+    [[nodiscard]] auto root() noexcept -> value& {
+        return document_.root();
+    }
+
+    [[nodiscard]] auto resource() const noexcept -> std::pmr::memory_resource* {
+        return document_.resource();
+    }
+
+    // The mapped file contents.
+    [[nodiscard]] auto text() const noexcept -> std::string_view {
+        return file_.text();
+    }
+
+private:
+    mapped_file file_;
+    document document_;
+};
+
+// A binary tape navigated in place inside a mapped file; nothing is decoded
+// or copied. Opening reads the tape once to check its structure.
+class tape_file {
+public:
+    explicit tape_file(const std::filesystem::path& path)
+        : file_{ path }, view_{ file_.text() } {}
+
+    [[nodiscard]] auto root() const -> tape_value {
+        return view_.root();
+    }
+
+    [[nodiscard]] auto view() const noexcept -> const binary_tape_view& {
+        return view_;
+    }
+
+private:
+    mapped_file file_;
+    binary_tape_view view_;
+};
+
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <string_view>
+#include "json_string.hpp"
+
+namespace jsonpp {
+
+// Bounded table of object keys shared by any number of parsers, including
+// ones running concurrently. A key already in the table resolves to a
+// pointer into it with no allocation, and keys from the same table compare
+// by address. Lookups are lock-free; an insertion takes a mutex. Once
+// max_keys keys are held, or for keys longer than max_key_size, keys are
+// simply copied as usual, so hostile input cannot grow the table.
+//
+// The table must outlive every value holding one of its keys.
+class key_table {
+public:
+    explicit key_table(size_t max_keys = 4096, size_t max_key_size = 128)
+        : max_keys_{ max_keys },
+          max_key_size_{ max_key_size },
+          mask_{ std::bit_ceil(std::max<size_t>(max_keys * 2, 16)) - 1 },
+          slots_{ std::make_unique<std::atomic<const detail::interned_block*>[]>(mask_ + 1) } {}
+
+    key_table(const key_table&) = delete;
+    auto operator=(const key_table&) -> key_table& = delete;
+
+    // An interned key for text, or an ordinary copy from resource when the
+    // table cannot take it.
+    [[nodiscard]] auto intern(
+        std::string_view text,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    ) -> compact_string {
+        if (text.size() > max_key_size_) {
+            return compact_string{ text, resource };
+        }
+        const size_t hash = std::hash<std::string_view>{}(text);
+        if (const auto* entry = slots_[find_slot(text, hash)].load(std::memory_order_acquire)) {
+            return compact_string{ entry };
+        }
+        if (size() < max_keys_) {
+            if (const auto* entry = insert(text, hash)) {
+                return compact_string{ entry };
+            }
+        }
+        return compact_string{ text, resource };
+    }
+
+    [[nodiscard]] auto contains(std::string_view text) const noexcept -> bool {
+        if (text.size() > max_key_size_) {
+            return false;
+        }
+        const size_t hash = std::hash<std::string_view>{}(text);
+        return slots_[find_slot(text, hash)].load(std::memory_order_acquire) != nullptr;
+    }
+
+    [[nodiscard]] auto size() const noexcept -> size_t {
+        return size_.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] auto max_keys() const noexcept -> size_t {
+        return max_keys_;
+    }
+
+private:
+    size_t max_keys_;
+    size_t max_key_size_;
+    size_t mask_;
+    std::unique_ptr<std::atomic<const detail::interned_block*>[]> slots_;
+    std::atomic<size_t> size_{ 0 };
+    std::mutex insert_mutex_;
+    std::pmr::monotonic_buffer_resource arena_;
+
+    // Slot holding text, or the empty slot where it would go. There are at
+    // least twice as many slots as keys, so probing always ends, and slots
+    // are never cleared, so a reader racing an insertion at worst misses
+    // the new key and retries under the lock.
+    [[nodiscard]] auto find_slot(std::string_view text, size_t hash) const noexcept -> size_t {
+        for (size_t slot = hash & mask_;; slot = (slot + 1) & mask_) {
+            const auto* entry = slots_[slot].load(std::memory_order_acquire);
+            if (entry == nullptr || (entry->hash == hash && entry->block.view() == text)) {
+                return slot;
+            }
+        }
+    }
+
+    [[nodiscard]] auto insert(std::string_view text, size_t hash) -> const detail::interned_block* {
+        std::lock_guard lock{ insert_mutex_ };
+        const size_t slot = find_slot(text, hash);
+        if (const auto* existing = slots_[slot].load(std::memory_order_relaxed)) {
+            return existing;
+        }
+        if (size_.load(std::memory_order_relaxed) >= max_keys_) {
+            return nullptr;
+        }
+
+        void* storage = arena_.allocate(sizeof(detail::interned_block) + text.size(), alignof(detail::interned_block));
+        auto* entry = ::new (storage) detail::interned_block{ hash, { &arena_, text.size() } };
+        if (!text.empty()) {
+            std::memcpy(reinterpret_cast<char*>(entry + 1), text.data(), text.size());
+        }
+        slots_[slot].store(entry, std::memory_order_release);
+        size_.fetch_add(1, std::memory_order_relaxed);
+        return entry;
+    }
+};
+
+}
@@ -0,0 +1,316 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include "json_value.hpp"
+#include "json_parser.hpp"
+#include "json_exception.hpp"
+#include "json_simd.hpp"
+
+namespace jsonpp {
+
+namespace detail {
+
+    // Skipping helpers for input that has already been validated.
+    [[nodiscard]] inline auto skip_valid_string(std::string_view text, size_t position) noexcept -> size_t {
+        ++position;
+        while (position < text.size()) {
+            position += plain_string_run(text.data() + position, text.size() - position);
+            if (position >= text.size()) {
+                break;
+            }
+            const char ch = text[position];
+            if (ch == '"') {
+                return position + 1;
+            }
+            position += ch == '\\' ? 2 : 1;
+        }
+        return text.size();
+    }
+
+    [[nodiscard]] inline auto skip_valid_value(std::string_view text, size_t position) noexcept -> size_t {
+        const char first = text[position];
+        if (first == '"') {
+            return skip_valid_string(text, position);
+        }
+        if (first == '{' || first == '[') {
+            size_t depth = 0;
+            while (position < text.size()) {
+                const char ch = text[position];
+                if (ch == '"') {
+                    position = skip_valid_string(text, position);
+                    continue;
+                }
+                ++position;
+                if (ch == '{' || ch == '[') {
+                    ++depth;
+                } else if ((ch == '}' || ch == ']') && --depth == 0) {
+                    return position;
+                }
+            }
+            return text.size();
+        }
+        while (position < text.size()) {
+            const char ch = text[position];
+            if (is_whitespace(ch) || ch == ',' || ch == ']' || ch == '}') {
+                break;
+            }
+            ++position;
+        }
+        return position;
+    }
+
+    [[nodiscard]] inline auto skip_whitespace(std::string_view text, size_t position) noexcept -> size_t {
+        while (position < text.size() && is_whitespace(text[position])) {
+            ++position;
+        }
+        return position;
+    }
+
+}
+
+// A node of a lazy_document. It knows only its byte range until it is
+// accessed: scalars are decoded on first use and containers index their
+// members incrementally, stopping as soon as a lookup is satisfied. Decoded
+// results are cached, so nodes are not safe for concurrent access. Every
+// decode uses the options the document was created with, which must outlive
+// the node.
+class lazy_value {
+public:
+    lazy_value(std::string_view text, size_t begin, size_t end, const parse_options& options = default_options) noexcept
+        : text_{text}, options_{&options}, begin_{begin}, end_{end}, scan_{begin + 1} {}
+
+    [[nodiscard]] auto type() const noexcept -> value_type {
+        switch (text_[begin_]) {
+            case 'n': return value_type::null;
+            case 't':
+            case 'f': return value_type::boolean;
+            case '"': return value_type::string;
+            case '[': return value_type::array;
+            case '{': return value_type::object;
+            default: {
+                const auto token = raw_json();
+                return token.find_first_of(".eE") == std::string_view::npos
+                    ? value_type::integer
+                    : value_type::number;
+            }
+        }
+    }
+
+    [[nodiscard]] auto is_null() const noexcept -> bool { return type() == value_type::null; }
+    [[nodiscard]] auto is_boolean() const noexcept -> bool { return type() == value_type::boolean; }
+    [[nodiscard]] auto is_number() const noexcept -> bool { return type() == value_type::number; }
+    [[nodiscard]] auto is_integer() const noexcept -> bool { return type() == value_type::integer; }
+    [[nodiscard]] auto is_string() const noexcept -> bool { return type() == value_type::string; }
+    [[nodiscard]] auto is_array() const noexcept -> bool { return type() == value_type::array; }
+    [[nodiscard]] auto is_object() const noexcept -> bool { return type() == value_type::object; }
+
+    // The unparsed JSON text of this node.
+    [[nodiscard]] auto raw_json() const noexcept -> std::string_view {
+        return text_.substr(begin_, end_ - begin_);
+    }
+
+    // Key of this node within its parent object, if any.
+    [[nodiscard]] auto key() const noexcept -> std::string_view {
+        return decoded_key_ ? std::string_view{ *decoded_key_ } : key_;
+    }
+
+    [[nodiscard]] auto as_boolean() const -> boolean_type { return scalar().as_boolean(); }
+    [[nodiscard]] auto as_integer() const -> integer_type { return scalar().as_integer(); }
+    [[nodiscard]] auto as_number() const -> number_type { return scalar().as_number(); }
+    [[nodiscard]] auto as_string() const -> std::string_view { return scalar().as_string(); }
+
+    // Materializes this node and everything below it.
+    [[nodiscard]] auto to_value() const -> value {
+        parser p{ raw_json(), *options_ };
+        return p.parse();
+    }
+
+    [[nodiscard]] auto size() const -> size_t {
+        require_container();
+        index_all();
+        return children().size();
+    }
+
+    [[nodiscard]] auto empty() const -> bool {
+        require_container();
+        return children().empty() && !index_next();
+    }
+
+    [[nodiscard]] auto operator[](size_t index) const -> const lazy_value& {
+        if (!is_array()) {
+            throw type_exception{"Value is not an array"};
+        }
+        while (children().size() <= index && index_next()) {
+        }
+        if (index >= children().size()) {
+            throw std::out_of_range{std::format("Index {} out of range", index)};
+        }
+        return children()[index];
+    }
+
+    [[nodiscard]] auto contains(std::string_view key) const -> bool {
+        return is_object() && find(key) != nullptr;
+    }
+
+    [[nodiscard]] auto at(std::string_view key) const -> const lazy_value& {
+        if (!is_object()) {
+            throw type_exception{"Value is not an object"};
+        }
+        if (const auto* child = find(key)) {
+            return *child;
+        }
+        throw std::out_of_range{std::format("Key '{}' not found", key)};
+    }
+
+    [[nodiscard]] auto operator[](std::string_view key) const -> const lazy_value& {
+        return at(key);
+    }
+
+    // Children in document order; object members carry their key().
+    [[nodiscard]] auto as_array() const -> const std::deque<lazy_value>& {
+        if (!is_array()) {
+            throw type_exception{"Value is not an array"};
+        }
+        index_all();
+        return children();
+    }
+
+    [[nodiscard]] auto as_object() const -> const std::deque<lazy_value>& {
+        if (!is_object()) {
+            throw type_exception{"Value is not an object"};
+        }
+        index_all();
+        return children();
+    }
+
+private:
+    static inline const parse_options default_options{};
+
+    std::string_view text_;
+    const parse_options* options_;
+    size_t begin_;
+    size_t end_;
+    std::string_view key_;
+    std::optional<std::string> decoded_key_;
+
+    mutable std::optional<value> scalar_;
+    mutable std::unique_ptr<std::deque<lazy_value>> children_;
+    mutable size_t scan_;
+    mutable bool indexed_ = false;
+
+    [[nodiscard]] auto children() const -> std::deque<lazy_value>& {
+        if (!children_) {
+            children_ = std::make_unique<std::deque<lazy_value>>();
+        }
+        return *children_;
+    }
+
+    auto require_container() const -> void {
+        if (!is_array() && !is_object()) {
+            throw type_exception{"Value is not an array or object"};
+        }
+    }
+
+    [[nodiscard]] auto scalar() const -> const value& {
+        if (!scalar_) {
+            parse_options options = *options_;
+            options.borrow_strings = true;
+            parser p{ raw_json(), options };
+            scalar_ = p.parse();
+        }
+        return *scalar_;
+    }
+
+    [[nodiscard]] auto find(std::string_view key) const -> const lazy_value* {
+        for (const auto& child : children()) {
+            if (child.key() == key) {
+                return &child;
+            }
+        }
+        while (index_next()) {
+            if (children_->back().key() == key) {
+                return &children_->back();
+            }
+        }
+        return nullptr;
+    }
+
+    auto index_all() const -> void {
+        while (index_next()) {
+        }
+    }
+
+    // Records the next member of this container; false once all are known.
+    auto index_next() const -> bool {
+        if (indexed_) {
+            return false;
+        }
+        size_t position = detail::skip_whitespace(text_, scan_);
+        if (text_[position] == ',') {
+            position = detail::skip_whitespace(text_, position + 1);
+        }
+        if (text_[position] == '}' || text_[position] == ']') {
+            indexed_ = true;
+            return false;
+        }
+
+        std::string_view key;
+        std::optional<std::string> decoded_key;
+        if (text_[begin_] == '{') {
+            const size_t key_end = detail::skip_valid_string(text_, position);
+            key = text_.substr(position + 1, key_end - position - 2);
+            if (key.find('\\') != std::string_view::npos) {
+                parser p{ text_.substr(position, key_end - position), *options_ };
+                decoded_key.emplace(p.parse().as_string());
+            }
+            position = detail::skip_whitespace(text_, key_end) + 1;
+            position = detail::skip_whitespace(text_, position);
+        }
+
+        const size_t value_end = detail::skip_valid_value(text_, position);
+        auto& child = children().emplace_back(text_, position, value_end, *options_);
+        child.key_ = key;
+        child.decoded_key_ = std::move(decoded_key);
+        scan_ = value_end;
+        return true;
+    }
+};
+
+// Lazily decoded view of a JSON text. Construction validates the whole input
+// without building anything; nodes are decoded only when reached, with the
+// same options. The text must outlive the document.
+class lazy_document {
+public:
+    explicit lazy_document(std::string_view text, const parse_options& options = {})
+        : text_{text},
+          options_{ std::make_unique<const parse_options>(options) },
+          root_{ validate(text, *options_) } {}
+
+    [[nodiscard]] auto root() const noexcept -> const lazy_value& {
+        return root_;
+    }
+
+private:
+    std::string_view text_;
+    // Nodes point at the options, so they stay put when the document moves.
+    std::unique_ptr<const parse_options> options_;
+    lazy_value root_;
+
+    [[nodiscard]] static auto validate(std::string_view text, const parse_options& options) -> lazy_value {
+        null_handler handler;
+        basic_parser<null_handler> p{ text, handler, options };
+        p.parse();
+
+        const size_t begin = detail::skip_whitespace(text, 0);
+        return lazy_value{ text, begin, detail::skip_valid_value(text, begin), options };
+    }
+};
+
+}
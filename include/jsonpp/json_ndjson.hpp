@@ -0,0 +1,130 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <cstring>
+#include "json_value.hpp"
+#include "json_parser.hpp"
+#include "json_parallel.hpp"
+#include "json_exception.hpp"
+
+namespace jsonpp {
+
+struct ndjson_options {
+    parse_options parse{};
+
+    // Approximate number of input bytes handed to one task.
+    size_t batch_size = size_t{ 1 } << 20;
+
+    // Defaults to thread_pool::shared().
+    thread_pool* pool = nullptr;
+};
+
+// One line of newline-delimited JSON. A line that fails to parse carries the
+// error, whose offset is within the whole input, and an empty value; it does
+// not affect the other records.
+struct ndjson_record {
+    size_t offset = 0;
+    value data;
+    std::optional<parse_error> error;
+
+    [[nodiscard]] auto ok() const noexcept -> bool {
+        return !error;
+    }
+};
+
+namespace detail {
+
+    [[nodiscard]] inline auto split_batches(std::string_view text, size_t batch_size)
+        -> std::vector<std::pair<size_t, size_t>> {
+        std::vector<std::pair<size_t, size_t>> batches;
+        batch_size = std::max<size_t>(batch_size, 1);
+
+        size_t begin = 0;
+        while (begin < text.size()) {
+            size_t end = std::min(begin + batch_size, text.size());
+            if (end < text.size()) {
+                const void* newline = std::memchr(text.data() + end, '\n', text.size() - end);
+                end = newline != nullptr
+                    ? static_cast<size_t>(static_cast<const char*>(newline) - text.data()) + 1
+                    : text.size();
+            }
+            batches.emplace_back(begin, end);
+            begin = end;
+        }
+        return batches;
+    }
+
+    inline auto parse_ndjson_batch(
+        std::string_view text,
+        size_t begin,
+        size_t end,
+        const parse_options& options,
+        std::vector<ndjson_record>& out
+    ) -> void {
+        while (begin < end) {
+            const void* newline = std::memchr(text.data() + begin, '\n', end - begin);
+            const size_t line_end = newline != nullptr
+                ? static_cast<size_t>(static_cast<const char*>(newline) - text.data())
+                : end;
+
+            size_t first = begin;
+            while (first < line_end && is_whitespace(text[first])) {
+                ++first;
+            }
+            if (first < line_end) {
+                auto& record = out.emplace_back();
+                record.offset = begin;
+                parser p{ text.substr(begin, line_end - begin), options };
+                if (auto result = p.try_parse()) {
+                    record.data = std::move(*result);
+                } else {
+                    record.error = result.error();
+                    record.error->offset += begin;
+                }
+            }
+            begin = line_end + 1;
+        }
+    }
+
+}
+
+// Parses newline-delimited JSON in parallel batches and calls
+// callback(ndjson_record&&) for every non-blank line, in input order.
+template <typename Callback>
+auto for_each_ndjson(std::string_view text, Callback&& callback, const ndjson_options& options = {}) -> void {
+    auto& pool = options.pool != nullptr ? *options.pool : thread_pool::shared();
+    const auto batches = detail::split_batches(text, options.batch_size);
+
+    // Batches are processed in waves so only a bounded number of parsed
+    // records is held before being handed to the callback.
+    const size_t wave_size = pool.size() * 2;
+    std::vector<std::vector<ndjson_record>> results(wave_size);
+
+    for (size_t wave = 0; wave < batches.size(); wave += wave_size) {
+        const size_t count = std::min(wave_size, batches.size() - wave);
+        pool.for_each_index(count, [&](size_t i) {
+            results[i].clear();
+            const auto [begin, end] = batches[wave + i];
+            detail::parse_ndjson_batch(text, begin, end, options.parse, results[i]);
+        });
+        for (size_t i = 0; i < count; ++i) {
+            for (auto& record : results[i]) {
+                callback(std::move(record));
+            }
+        }
+    }
+}
+
+[[nodiscard]] inline auto parse_ndjson(std::string_view text, const ndjson_options& options = {})
+    -> std::vector<ndjson_record> {
+    std::vector<ndjson_record> records;
+    for_each_ndjson(text, [&](ndjson_record&& record) {
+        records.push_back(std::move(record));
+    }, options);
+    return records;
+}
+
+}
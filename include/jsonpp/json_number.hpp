@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <bit>
+#include <optional>
+
+namespace jsonpp::detail {
+
+[[nodiscard]] constexpr auto is_digit(char ch) noexcept -> bool {
+    return static_cast<unsigned char>(ch - '0') < 10;
+}
+
+[[nodiscard]] inline auto load_eight(const char* data) noexcept -> uint64_t {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    if constexpr (std::endian::native == std::endian::big) {
+        word = std::byteswap(word);
+    }
+    return word;
+}
+
+// True when all eight bytes are ASCII digits.
+[[nodiscard]] constexpr auto is_eight_digits(uint64_t word) noexcept -> bool {
+    return ((word & 0xF0F0F0F0F0F0F0F0) |
+            (((word + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333;
+}
+
+// Value of eight ASCII digits, first digit most significant, combined
+// pairwise within the word instead of one digit at a time.
+[[nodiscard]] constexpr auto parse_eight_digits(uint64_t word) noexcept -> uint32_t {
+    word = (word & 0x0F0F0F0F0F0F0F0F) * 2561 >> 8;
+    word = (word & 0x00FF00FF00FF00FF) * 6553601 >> 16;
+    return static_cast<uint32_t>((word & 0x0000FFFF0000FFFF) * 42949672960001 >> 32);
+}
+
+// Accumulates the digits in [p, last) into value and returns the first
+// non-digit. value wraps if more than 19 digits are read.
+[[nodiscard]] inline auto accumulate_digits(const char* p, const char* last, uint64_t& value) noexcept -> const char* {
+    while (last - p >= 8) {
+        const uint64_t word = load_eight(p);
+        if (!is_eight_digits(word)) {
+            break;
+        }
+        value = value * 100000000 + parse_eight_digits(word);
+        p += 8;
+    }
+    while (p != last && is_digit(*p)) {
+        value = value * 10 + static_cast<uint64_t>(*p - '0');
+        ++p;
+    }
+    return p;
+}
+
+// mantissa * 10^exponent when both are exactly representable as doubles,
+// so that a single rounding gives the correctly rounded result (Clinger's
+// fast path). Other inputs are left to std::from_chars.
+[[nodiscard]] inline auto exact_double(uint64_t mantissa, int64_t exponent, bool negative) noexcept
+    -> std::optional<double> {
+    constexpr double powers[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    if (mantissa > (uint64_t{ 1 } << 53) || exponent < -22 || exponent > 22) {
+        return std::nullopt;
+    }
+    double result = static_cast<double>(mantissa);
+    result = exponent < 0 ? result / powers[-exponent] : result * powers[exponent];
+    return negative ? -result : result;
+}
+
+}
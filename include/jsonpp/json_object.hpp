@@ -0,0 +1,398 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <memory_resource>
+#include <functional>
+#include <algorithm>
+#include <compare>
+#include <cstdint>
+#include <utility>
+#include <concepts>
+#include <type_traits>
+#include <iterator>
+
+namespace jsonpp {
+
+// Insertion-ordered object stored as one contiguous run of key/value pairs.
+// Small objects are searched linearly; once an object grows past
+// index_threshold members an open-addressing hash index over the entries is
+// built and kept up to date by every insertion.
+//
+// Entries are stored as std::pair<Key, Value> so that erase() and growth
+// can move keys. Iterators dereference to std::pair<const Key&, Value&>, as
+// std::flat_map's do, so a member cannot be renamed in place behind the
+// index's back.
+template <typename Key, typename Value>
+class basic_object {
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<Key, Value>;
+    using allocator_type = std::pmr::polymorphic_allocator<value_type>;
+    using size_type = size_t;
+
+    template <bool Const>
+    class member_iterator {
+        using entry_pointer = std::conditional_t<Const, const basic_object::value_type*, basic_object::value_type*>;
+        using mapped_reference = std::conditional_t<Const, const Value&, Value&>;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = basic_object::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::pair<const Key&, mapped_reference>;
+
+        // What operator-> points at: the reference pair, held by value.
+        class pointer {
+        public:
+            explicit pointer(reference member) noexcept
+                : member_{ member } {}
+
+            [[nodiscard]] auto operator->() const noexcept -> const reference* {
+                return &member_;
+            }
+
+        private:
+            reference member_;
+        };
+
+        member_iterator() noexcept = default;
+
+        explicit member_iterator(entry_pointer entry) noexcept
+            : entry_{ entry } {}
+
+        // iterator converts to const_iterator.
+        template <bool Other>
+            requires (Const && !Other)
+        member_iterator(const member_iterator<Other>& other) noexcept
+            : entry_{ other.entry_ } {}
+
+        [[nodiscard]] auto operator*() const noexcept -> reference {
+            return { entry_->first, entry_->second };
+        }
+
+        [[nodiscard]] auto operator->() const noexcept -> pointer {
+            return pointer{ **this };
+        }
+
+        [[nodiscard]] auto operator[](difference_type n) const noexcept -> reference {
+            return *(*this + n);
+        }
+
+        auto operator++() noexcept -> member_iterator& { ++entry_; return *this; }
+        auto operator--() noexcept -> member_iterator& { --entry_; return *this; }
+        auto operator++(int) noexcept -> member_iterator { auto copy = *this; ++entry_; return copy; }
+        auto operator--(int) noexcept -> member_iterator { auto copy = *this; --entry_; return copy; }
+        auto operator+=(difference_type n) noexcept -> member_iterator& { entry_ += n; return *this; }
+        auto operator-=(difference_type n) noexcept -> member_iterator& { entry_ -= n; return *this; }
+
+        [[nodiscard]] friend auto operator+(member_iterator it, difference_type n) noexcept -> member_iterator {
+            return it += n;
+        }
+
+        [[nodiscard]] friend auto operator+(difference_type n, member_iterator it) noexcept -> member_iterator {
+            return it += n;
+        }
+
+        [[nodiscard]] friend auto operator-(member_iterator it, difference_type n) noexcept -> member_iterator {
+            return it -= n;
+        }
+
+        [[nodiscard]] friend auto operator-(const member_iterator& lhs, const member_iterator& rhs) noexcept
+            -> difference_type {
+            return lhs.entry_ - rhs.entry_;
+        }
+
+        [[nodiscard]] friend auto operator==(const member_iterator&, const member_iterator&) noexcept -> bool = default;
+        [[nodiscard]] friend auto operator<=>(const member_iterator&, const member_iterator&) noexcept = default;
+
+    private:
+        template <bool>
+        friend class member_iterator;
+
+        entry_pointer entry_ = nullptr;
+    };
+
+    using iterator = member_iterator<false>;
+    using const_iterator = member_iterator<true>;
+
+    static constexpr size_t index_threshold = 16;
+
+    basic_object() = default;
+
+    explicit basic_object(const allocator_type& alloc)
+        : entries_{ alloc }, index_{ alloc } {}
+
+    basic_object(const basic_object& other)
+        : entries_{ other.entries_ }, index_{ entries_.get_allocator() } {
+        rebuild_index();
+    }
+
+    basic_object(basic_object&&) noexcept = default;
+
+    auto operator=(const basic_object& other) -> basic_object& {
+        if (this != &other) {
+            entries_ = other.entries_;
+            rebuild_index();
+        }
+        return *this;
+    }
+
+    auto operator=(basic_object&& other) -> basic_object& {
+        if (this != &other) {
+            entries_ = std::move(other.entries_);
+            rebuild_index();
+            other.index_.clear();
+        }
+        return *this;
+    }
+
+    [[nodiscard]] auto get_allocator() const noexcept -> allocator_type {
+        return entries_.get_allocator();
+    }
+
+    [[nodiscard]] auto begin() noexcept -> iterator { return at_index(0); }
+    [[nodiscard]] auto end() noexcept -> iterator { return at_index(entries_.size()); }
+    [[nodiscard]] auto begin() const noexcept -> const_iterator { return at_index(0); }
+    [[nodiscard]] auto end() const noexcept -> const_iterator { return at_index(entries_.size()); }
+
+    [[nodiscard]] auto size() const noexcept -> size_t {
+        return entries_.size();
+    }
+
+    [[nodiscard]] auto empty() const noexcept -> bool {
+        return entries_.empty();
+    }
+
+    // Heap buffers of the object itself, not counting its keys and values.
+    [[nodiscard]] auto buffer_count() const noexcept -> size_t {
+        return (entries_.capacity() != 0 ? 1 : 0) + (index_.capacity() != 0 ? 1 : 0);
+    }
+
+    [[nodiscard]] auto buffer_bytes() const noexcept -> size_t {
+        return entries_.capacity() * sizeof(value_type) + index_.capacity() * sizeof(uint32_t);
+    }
+
+    // Also sizes the hash index for count members, so filling a reserved
+    // object allocates nothing further.
+    auto reserve(size_t count) -> void {
+        entries_.reserve(count);
+        if (count > index_threshold && count * 2 > index_.size()) {
+            rebuild_index(count);
+        }
+    }
+
+    auto clear() noexcept -> void {
+        entries_.clear();
+        index_.clear();
+    }
+
+    [[nodiscard]] auto find(std::string_view key) -> iterator {
+        return at_index(find_index(key));
+    }
+
+    [[nodiscard]] auto find(std::string_view key) const -> const_iterator {
+        return at_index(find_index(key));
+    }
+
+    [[nodiscard]] auto contains(std::string_view key) const -> bool {
+        return find_index(key) != entries_.size();
+    }
+
+    // Lookup by a key of the object's own type, which can skip hashing and
+    // string comparison, such as for a key from a key_table.
+    template <std::same_as<Key> K>
+    [[nodiscard]] auto find(const K& key) -> iterator {
+        return at_index(find_index(key));
+    }
+
+    template <std::same_as<Key> K>
+    [[nodiscard]] auto find(const K& key) const -> const_iterator {
+        return at_index(find_index(key));
+    }
+
+    template <std::same_as<Key> K>
+    [[nodiscard]] auto contains(const K& key) const -> bool {
+        return find_index(key) != entries_.size();
+    }
+
+    template <typename K, typename... Args>
+    auto try_emplace(K&& key, Args&&... args) -> std::pair<iterator, bool> {
+        size_t existing;
+        if constexpr (std::same_as<std::remove_cvref_t<K>, Key>) {
+            existing = find_index(key);
+        } else {
+            existing = find_index(std::string_view{ key });
+        }
+        if (existing != entries_.size()) {
+            return { at_index(existing), false };
+        }
+
+        entries_.emplace_back(
+            std::piecewise_construct,
+            std::forward_as_tuple(std::forward<K>(key)),
+            std::forward_as_tuple(std::forward<Args>(args)...)
+        );
+        index_inserted();
+        return { at_index(entries_.size() - 1), true };
+    }
+
+    template <typename K, typename V>
+    auto emplace(K&& key, V&& val) -> std::pair<iterator, bool> {
+        return try_emplace(std::forward<K>(key), std::forward<V>(val));
+    }
+
+    auto operator[](std::string_view key) -> Value& {
+        return try_emplace(key).first->second;
+    }
+
+    auto erase(std::string_view key) -> size_t {
+        const size_t position = find_index(key);
+        if (position == entries_.size()) {
+            return 0;
+        }
+        entries_.erase(entries_.begin() + static_cast<std::ptrdiff_t>(position));
+        rebuild_index();
+        return 1;
+    }
+
+    // Moves the members of source whose keys are not present yet to the end
+    // of this object, keys included, and leaves source empty.
+    auto merge(basic_object&& source) -> void {
+        for (auto& [key, val] : source.entries_) {
+            if (find_index(key) == entries_.size()) {
+                entries_.emplace_back(std::move(key), std::move(val));
+                index_inserted();
+            }
+        }
+        source.clear();
+    }
+
+    friend auto operator==(const basic_object& lhs, const basic_object& rhs) -> bool {
+        if (lhs.size() != rhs.size()) {
+            return false;
+        }
+        for (const auto& [key, val] : lhs.entries_) {
+            const auto it = rhs.find(key);
+            if (it == rhs.end() || !(it->second == val)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend auto operator<=>(const basic_object& lhs, const basic_object& rhs) -> std::partial_ordering {
+        const auto l = lhs.sorted_entries();
+        const auto r = rhs.sorted_entries();
+        return std::lexicographical_compare_three_way(
+            l.begin(), l.end(), r.begin(), r.end(),
+            [](const value_type* a, const value_type* b) -> std::partial_ordering {
+                if (const auto cmp = std::string_view{ a->first } <=> std::string_view{ b->first }; cmp != 0) {
+                    return cmp;
+                }
+                return a->second <=> b->second;
+            }
+        );
+    }
+
+private:
+    std::pmr::vector<value_type> entries_;
+    std::pmr::vector<uint32_t> index_;
+
+    [[nodiscard]] auto at_index(size_t position) noexcept -> iterator {
+        return iterator{ entries_.data() + position };
+    }
+
+    [[nodiscard]] auto at_index(size_t position) const noexcept -> const_iterator {
+        return const_iterator{ entries_.data() + position };
+    }
+
+    [[nodiscard]] static auto hash_key(std::string_view key) noexcept -> size_t {
+        return std::hash<std::string_view>{}(key);
+    }
+
+    // Keys that carry their own hash, like compact_string, must agree with
+    // std::hash<std::string_view>.
+    [[nodiscard]] static auto hash_key(const Key& key) noexcept -> size_t {
+        if constexpr (requires { { key.hash() } -> std::convertible_to<size_t>; }) {
+            return key.hash();
+        } else {
+            return std::hash<std::string_view>{}(std::string_view{ key });
+        }
+    }
+
+    template <typename K>
+    [[nodiscard]] auto find_index(const K& key) const -> size_t {
+        if (index_.empty()) {
+            for (size_t i = 0; i < entries_.size(); ++i) {
+                if (entries_[i].first == key) {
+                    return i;
+                }
+            }
+            return entries_.size();
+        }
+
+        const size_t mask = index_.size() - 1;
+        for (size_t slot = hash_key(key) & mask; index_[slot] != 0; slot = (slot + 1) & mask) {
+            const size_t i = index_[slot] - 1;
+            if (entries_[i].first == key) {
+                return i;
+            }
+        }
+        return entries_.size();
+    }
+
+    auto insert_into_index(size_t position) -> void {
+        const size_t mask = index_.size() - 1;
+        size_t slot = hash_key(entries_[position].first) & mask;
+        while (index_[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        index_[slot] = static_cast<uint32_t>(position + 1);
+    }
+
+    auto index_inserted() -> void {
+        if (index_.empty()) {
+            if (entries_.size() > index_threshold) {
+                rebuild_index();
+            }
+            return;
+        }
+        if (entries_.size() * 2 > index_.size()) {
+            rebuild_index();
+            return;
+        }
+        insert_into_index(entries_.size() - 1);
+    }
+
+    auto rebuild_index(size_t expected = 0) -> void {
+        index_.clear();
+        const size_t target = std::max(expected, entries_.size());
+        if (target <= index_threshold) {
+            return;
+        }
+        size_t capacity = 64;
+        while (capacity < target * 4) {
+            capacity *= 2;
+        }
+        index_.assign(capacity, 0);
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            insert_into_index(i);
+        }
+    }
+
+    [[nodiscard]] auto sorted_entries() const -> std::vector<const value_type*> {
+        std::vector<const value_type*> result;
+        result.reserve(entries_.size());
+        for (const auto& entry : entries_) {
+            result.push_back(&entry);
+        }
+        std::ranges::sort(result, [](const value_type* a, const value_type* b) {
+            return std::string_view{ a->first } < std::string_view{ b->first };
+        });
+        return result;
+    }
+};
+
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <exception>
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+
+namespace jsonpp {
+
+// Fixed set of worker threads used by the batch and parallel parsers. A call
+// to for_each_index hands indices out one at a time through an atomic
+// counter, so threads that finish early keep taking work.
+class thread_pool {
+public:
+    explicit thread_pool(size_t threads = std::thread::hardware_concurrency()) {
+        const size_t workers = std::max<size_t>(threads, 1) - 1;
+        workers_.reserve(workers);
+        for (size_t i = 0; i < workers; ++i) {
+            workers_.emplace_back([this](std::stop_token stop) { work(stop); });
+        }
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    auto operator=(const thread_pool&) -> thread_pool& = delete;
+
+    ~thread_pool() {
+        for (auto& worker : workers_) {
+            worker.request_stop();
+        }
+        {
+            std::lock_guard lock{ mutex_ };
+            ++generation_;
+        }
+        wake_.notify_all();
+        workers_.clear();
+    }
+
+    // Number of threads taking part in a call, including the caller.
+    [[nodiscard]] auto size() const noexcept -> size_t {
+        return workers_.size() + 1;
+    }
+
+    [[nodiscard]] static auto shared() -> thread_pool& {
+        static thread_pool pool{};
+        return pool;
+    }
+
+    // Runs task(i) for every i in [0, count) and returns once all calls have
+    // finished, rethrowing the first exception a task threw. The calling thread
+    // works too. Tasks must not call back into the same pool.
+    template <typename Task>
+    auto for_each_index(size_t count, Task&& task) -> void {
+        if (count == 0) {
+            return;
+        }
+        if (workers_.empty() || count == 1) {
+            for (size_t i = 0; i < count; ++i) {
+                task(i);
+            }
+            return;
+        }
+
+        std::lock_guard run_lock{ run_mutex_ };
+        job current{
+            const_cast<void*>(static_cast<const void*>(std::addressof(task))),
+            [](void* context, size_t index) { (*static_cast<std::remove_reference_t<Task>*>(context))(index); },
+            count
+        };
+        {
+            std::lock_guard lock{ mutex_ };
+            job_ = &current;
+            active_ = workers_.size();
+            ++generation_;
+        }
+        wake_.notify_all();
+
+        run(current);
+
+        std::unique_lock lock{ mutex_ };
+        finished_.wait(lock, [this] { return active_ == 0; });
+        job_ = nullptr;
+        if (current.error) {
+            std::rethrow_exception(current.error);
+        }
+    }
+
+private:
+    struct job {
+        void* context;
+        void (*invoke)(void*, size_t);
+        size_t count;
+        std::atomic<size_t> next{ 0 };
+        std::mutex error_mutex{};
+        std::exception_ptr error{};
+    };
+
+    std::vector<std::jthread> workers_;
+    std::mutex run_mutex_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable finished_;
+    job* job_ = nullptr;
+    size_t active_ = 0;
+    size_t generation_ = 0;
+
+    static auto run(job& current) -> void {
+        for (size_t index = current.next.fetch_add(1); index < current.count;
+             index = current.next.fetch_add(1)) {
+            try {
+                current.invoke(current.context, index);
+            } catch (...) {
+                std::lock_guard lock{ current.error_mutex };
+                if (!current.error) {
+                    current.error = std::current_exception();
+                }
+                current.next.store(current.count);
+            }
+        }
+    }
+
+    auto work(std::stop_token stop) -> void {
+        size_t seen = 0;
+        while (true) {
+            job* current = nullptr;
+            {
+                std::unique_lock lock{ mutex_ };
+                wake_.wait(lock, [&] { return generation_ != seen || stop.stop_requested(); });
+                if (stop.stop_requested()) {
+                    return;
+                }
+                seen = generation_;
+                current = job_;
+            }
+            if (current != nullptr) {
+                run(*current);
+            }
+            {
+                std::lock_guard lock{ mutex_ };
+                --active_;
+            }
+            finished_.notify_one();
+        }
+    }
+};
+
+}
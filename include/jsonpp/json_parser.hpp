@@ -1,41 +1,345 @@
 #pragma once
 
 #include <string_view>
+#include <cstring>
 #include <charconv>
 #include <cctype>
+#include <limits>
 #include <optional>
+#include <memory_resource>
+#include <concepts>
+#include <functional>
+#include <vector>
+#include <algorithm>
+#include <expected>
 #include "json_value.hpp"
+#include "json_intern.hpp"
 #include "json_exception.hpp"
+#include "json_scanner.hpp"
+#include "json_number.hpp"
+#include "json_stats.hpp"
+#include "json_stack.hpp"
 
 namespace jsonpp {
 
-class parser {
+// What to do with an integer literal outside the int64_t range.
+enum class big_integer_mode {
+    // Throw a parse_exception.
+    error,
+    // Parse it as a double, losing precision beyond 2^53.
+    as_double,
+    // Keep the digits unchanged as a string value.
+    as_string
+};
+
+struct parse_options {
+    // Run the SIMD structural scan first and let the grammar jump between
+    // token offsets. Pays off on large or pretty-printed inputs.
+    bool structural_index = false;
+
+    // Escape-free strings become views into the input instead of copies.
+    // The input must outlive the parsed value.
+    bool borrow_strings = false;
+
+    big_integer_mode big_integers = big_integer_mode::error;
+
+    // Object keys are resolved through this table when set; see key_table.
+    key_table* keys = nullptr;
+
+    // Decoding a described type fails when a member other than a
+    // std::optional one is absent, instead of leaving it defaulted.
+    bool require_members = false;
+
+    // Reject strings and keys that are not well-formed UTF-8, as RFC 8259
+    // requires. Off by default for speed and compatibility; validate()
+    // always turns it on.
+    bool validate_utf8 = false;
+
+    // Arrays and objects nested deeper than this are rejected with
+    // parse_errc::depth_exceeded. The parser itself needs no native stack
+    // for nesting, but destroying, comparing or hashing a value still
+    // recurses, so hostile input is stopped here.
+    size_t max_depth = 1024;
+};
+
+[[nodiscard]] constexpr auto is_whitespace(char ch) noexcept -> bool {
+    return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t';
+}
+
+// Receives the events of a parse in document order. String and key views
+// are only valid for the duration of the call unless they point into the
+// parser input.
+template <typename Handler>
+concept sax_handler = requires(Handler& h, std::string_view text, integer_type i, number_type n, bool b, size_t count) {
+    h.on_null();
+    h.on_bool(b);
+    h.on_int(i);
+    h.on_double(n);
+    h.on_string(text);
+    h.on_key(text);
+    h.start_object();
+    h.end_object(count);
+    h.start_array();
+    h.end_array(count);
+};
+
+// Discards every event, so running basic_parser with it only checks that the
+// input is well-formed. Since it ignores strings, escaped ones are checked
+// without being decoded and nothing is allocated.
+struct null_handler {
+    static constexpr bool ignores_string_values = true;
+    static constexpr bool ignores_keys = true;
+
+    auto on_null() noexcept -> void {}
+    auto on_bool(bool) noexcept -> void {}
+    auto on_int(integer_type) noexcept -> void {}
+    auto on_double(number_type) noexcept -> void {}
+    auto on_string(std::string_view) noexcept -> void {}
+    auto on_key(std::string_view) noexcept -> void {}
+    auto start_object() noexcept -> void {}
+    auto end_object(size_t) noexcept -> void {}
+    auto start_array() noexcept -> void {}
+    auto end_array(size_t) noexcept -> void {}
+};
+
+template <sax_handler Handler>
+class basic_parser {
 public:
-    explicit parser(std::string_view input) noexcept 
-        : input_{input}, position_{0} {}
+    basic_parser(std::string_view input, Handler& handler, const parse_options& options = {}) noexcept
+        : input_{input}, position_{0}, handler_{handler}, options_{options} {}
 
-    [[nodiscard]] auto parse() -> value {
+    auto parse() -> void {
+        if (const auto result = try_parse(); !result) {
+            throw parse_exception{ result.error() };
+        }
+    }
+
+    // Reports malformed input through the return value instead of throwing,
+    // so rejecting it costs no unwinding or formatting. Exceptions thrown by
+    // the handler itself still propagate.
+    [[nodiscard]] auto try_parse() -> std::expected<void, parse_error> {
+        start();
+        if (!parse_value() || !at_end()) {
+            return std::unexpected{ error_ };
+        }
+        finish_stats();
+        return {};
+    }
+
+    // Pull interface for decoders that know the shape they expect, such as
+    // the struct mapping in json_struct.hpp. A parse through it is bracketed
+    // by start() and finish(); every call in between skips whitespace first.
+    auto start() -> void {
+        recorder_.begin();
+        containers_.truncate(0);
+        pull_depth_ = 0;
+        if (options_.structural_index) {
+            [[maybe_unused]] const auto timer = recorder_.time(&parse_stats::scan_ns);
+            // An input ending inside a string is left to the plain grammar,
+            // which reports the error at the right offset.
+            indexed_ = index_.build(input_);
+            cursor_ = 0;
+        }
         skip_whitespace();
-        auto result = parse_value();
+    }
+
+    // Starts a pull parse at offset rather than at the beginning, so that a
+    // piece of a larger input is parsed with offsets relative to the whole.
+    auto start_at(size_t offset) -> void {
+        position_ = std::min(offset, input_.size());
+        start();
+    }
+
+    auto finish() -> void {
+        if (!at_end()) {
+            raise();
+        }
+        finish_stats();
+    }
+
+    [[nodiscard]] auto peek_token() -> char {
         skip_whitespace();
-        
-        if (position_ < input_.size()) {
-            throw parse_exception{"Unexpected characters after JSON value", position_};
+        const auto ch = peek();
+        if (!ch) {
+            fail(parse_errc::unexpected_end, position_);
+            raise();
+        }
+        return *ch;
+    }
+
+    // Brackets consumed here count towards max_depth, so values read or
+    // skipped inside them are limited to the levels that remain.
+    auto expect_token(char expected) -> void {
+        skip_whitespace();
+        const bool opens = expected == '[' || expected == '{';
+        if (opens && pull_depth_ >= options_.max_depth) {
+            fail(parse_errc::depth_exceeded, position_);
+            raise();
+        }
+        if (!expect(expected)) {
+            raise();
+        }
+        if (opens) {
+            ++pull_depth_;
+        } else if ((expected == ']' || expected == '}') && pull_depth_ > 0) {
+            --pull_depth_;
         }
-        
-        return result;
+    }
+
+    // The view is valid until the next string is read.
+    [[nodiscard]] auto read_string() -> std::string_view {
+        skip_whitespace();
+        std::string_view text;
+        if (!parse_string(text)) {
+            raise();
+        }
+        return text;
+    }
+
+    // Consumes literal when the next token starts with it, without reporting
+    // anything to the handler; decoders use it to recognise expected keys.
+    [[nodiscard]] auto match(std::string_view literal) noexcept -> bool {
+        skip_whitespace();
+        if (input_.size() - position_ < literal.size() ||
+            std::memcmp(input_.data() + position_, literal.data(), literal.size()) != 0) {
+            return false;
+        }
+        position_ += literal.size();
+        return true;
+    }
+
+    // Parses one complete value, reporting it to the handler.
+    auto read_value() -> void {
+        if (!parse_value()) {
+            raise();
+        }
+    }
+
+    // Checks one complete value and steps over it without reporting it to
+    // the handler or decoding its strings.
+    auto skip_value() -> void {
+        if (!parse_value<false>()) {
+            raise();
+        }
+    }
+
+    [[nodiscard]] auto position() const noexcept -> size_t {
+        return position_;
+    }
+
+    // Counters of the last completed parse; all zero unless
+    // JSONPP_ENABLE_STATS is defined.
+    [[nodiscard]] auto stats() const noexcept -> parse_stats {
+        return recorder_.stats();
+    }
+
+    // Points the parser at another input, keeping its scratch buffer and
+    // structural index, so a long-lived parser stops allocating once they
+    // have grown to fit the documents it sees.
+    auto reset(std::string_view input, const parse_options& options) noexcept -> void {
+        input_ = input;
+        position_ = 0;
+        options_ = options;
+        cursor_ = 0;
+        indexed_ = false;
+        error_ = {};
+        containers_.truncate(0);
+        pull_depth_ = 0;
+    }
+
+    [[nodiscard]] auto retained_bytes() const noexcept -> size_t {
+        return scratch_.capacity() + index_.capacity_bytes() + containers_.capacity_bytes();
+    }
+
+    auto release_buffers() noexcept -> void {
+        std::string{}.swap(scratch_);
+        index_.shrink();
+        containers_.shrink();
     }
 
 private:
+    // Handlers can declare that they ignore the contents of string values or
+    // keys; escaped ones are then validated without being decoded and the
+    // handler sees an empty view.
+    static constexpr bool decode_values = !requires { requires Handler::ignores_string_values; };
+    static constexpr bool decode_keys = !requires { requires Handler::ignores_keys; };
+
     std::string_view input_;
     size_t position_;
+    Handler& handler_;
+    parse_options options_;
+    std::string scratch_;
+    structural_index index_;
+    size_t cursor_ = 0;
+    bool indexed_ = false;
+    parse_error error_{};
+    [[no_unique_address]] detail::parse_recorder recorder_;
+
+    // An array or object whose closing bracket has not been reached yet.
+    struct open_container {
+        size_t count;
+        bool object;
+    };
+
+    detail::inline_stack<open_container, 32> containers_;
+    // Containers opened through expect_token and not yet closed.
+    size_t pull_depth_ = 0;
+
+    // Handlers that allocate, like dom_builder, report what they allocated
+    // through allocation_stats().
+    auto finish_stats() noexcept -> void {
+        if constexpr (stats_enabled) {
+            if constexpr (requires { handler_.allocation_stats(); }) {
+                const parse_stats& allocated = handler_.allocation_stats();
+                recorder_.stats().allocations = allocated.allocations;
+                recorder_.stats().allocated_bytes = allocated.allocated_bytes;
+            }
+            recorder_.finish(position_);
+        }
+    }
+
+    // Every grammar function returns false once it has recorded an error
+    // here; the pull interface turns that into a parse_exception.
+    auto fail(parse_errc code, size_t offset, char found = '\0', char expected = '\0') noexcept -> bool {
+        error_ = parse_error{ code, offset, found, expected };
+        return false;
+    }
+
+    [[noreturn]] auto raise() const -> void {
+        throw parse_exception{ error_ };
+    }
+
+    [[nodiscard]] auto at_end() noexcept -> bool {
+        skip_whitespace();
+        if (position_ < input_.size()) {
+            return fail(parse_errc::trailing_characters, position_);
+        }
+        return true;
+    }
 
     auto skip_whitespace() noexcept -> void {
-        while (position_ < input_.size() && std::isspace(input_[position_])) {
+        if (indexed_) {
+            skip_to_next_structural();
+            return;
+        }
+        while (position_ < input_.size() && is_whitespace(input_[position_])) {
             ++position_;
         }
     }
 
+    // Any non-whitespace byte following whitespace outside a string is itself
+    // indexed, so jumping is safe whenever we are not in the middle of a
+    // token; otherwise stay put and let the grammar report the stray byte.
+    auto skip_to_next_structural() noexcept -> void {
+        while (cursor_ < index_.size() && index_[cursor_] < position_) {
+            ++cursor_;
+        }
+        if (position_ < input_.size() && !is_whitespace(input_[position_])) {
+            return;
+        }
+        position_ = cursor_ < index_.size() ? index_[cursor_] : input_.size();
+    }
+
     [[nodiscard]] auto peek() const noexcept -> std::optional<char> {
         if (position_ >= input_.size()) {
             return std::nullopt;
@@ -43,166 +347,379 @@ private:
         return input_[position_];
     }
 
-    [[nodiscard]] auto consume() -> char {
+    [[nodiscard]] auto expect(char expected) noexcept -> bool {
         if (position_ >= input_.size()) {
-            throw parse_exception{"Unexpected end of input", position_};
+            return fail(parse_errc::unexpected_end, position_);
         }
-        return input_[position_++];
+        const char ch = input_[position_++];
+        if (ch != expected) {
+            return fail(parse_errc::expected_token, position_ - 1, ch, expected);
+        }
+        return true;
     }
 
-    auto expect(char expected) -> void {
-        const auto ch = consume();
-        if (ch != expected) {
-            throw parse_exception{
-                std::format("Expected '{}', got '{}'", expected, ch), 
-                position_ - 1
-            };
+    // Parses one complete value without recursing: containers still open
+    // wait on containers_, so nesting costs no native stack, and the depth
+    // is checked against max_depth as each container opens. Unless Report,
+    // the value is only validated and the handler hears nothing of it.
+    template <bool Report = true>
+    [[nodiscard]] auto parse_value() -> bool {
+        if (!parse_nested<Report>()) {
+            containers_.truncate(0);
+            return false;
         }
+        return true;
     }
 
-    [[nodiscard]] auto parse_value() -> value {
-        skip_whitespace();
-        
-        const auto ch = peek();
-        if (!ch) {
-            throw parse_exception{"Unexpected end of input", position_};
+    // The innermost open container is kept here rather than on
+    // containers_, which holds only the ones enclosing it. Depth starts at
+    // the containers already entered through the pull interface.
+    struct nesting {
+        open_container top{};
+        size_t base = 0;
+        size_t depth = 0;
+    };
+
+    template <bool Report>
+    [[nodiscard]] auto parse_nested() -> bool {
+        nesting level{ .base = pull_depth_, .depth = pull_depth_ };
+        while (true) {
+            skip_whitespace();
+
+            const auto ch = peek();
+            if (!ch) {
+                return fail(parse_errc::unexpected_end, position_);
+            }
+
+            switch (*ch) {
+                case '[':
+                    if (!open<Report>(level, false)) {
+                        return false;
+                    }
+                    skip_whitespace();
+                    if (peek() != ']') {
+                        continue;
+                    }
+                    ++position_;
+                    close<Report>(level);
+                    break;
+                case '{':
+                    if (!open<Report>(level, true)) {
+                        return false;
+                    }
+                    skip_whitespace();
+                    if (peek() != '}') {
+                        if (!parse_key<Report>()) {
+                            return false;
+                        }
+                        continue;
+                    }
+                    ++position_;
+                    close<Report>(level);
+                    break;
+                default:
+                    if (!parse_scalar<Report>(*ch)) {
+                        return false;
+                    }
+                    break;
+            }
+
+            // A value is complete: close the containers it completes, then
+            // step to the next element or member.
+            while (level.depth > level.base) {
+                ++level.top.count;
+                skip_whitespace();
+
+                const auto next = peek();
+                if (level.top.object) {
+                    if (!next) {
+                        return fail(parse_errc::unterminated_object, position_);
+                    }
+                    if (*next == '}') {
+                        ++position_;
+                        close<Report>(level);
+                        continue;
+                    }
+                    if (*next != ',') {
+                        return fail(parse_errc::expected_object_separator, position_, *next);
+                    }
+                    ++position_;
+                    skip_whitespace();
+                    if (peek() == '}') {
+                        return fail(parse_errc::trailing_comma_in_object, position_);
+                    }
+                    if (!parse_key<Report>()) {
+                        return false;
+                    }
+                } else {
+                    if (!next) {
+                        return fail(parse_errc::unterminated_array, position_);
+                    }
+                    if (*next == ']') {
+                        ++position_;
+                        close<Report>(level);
+                        continue;
+                    }
+                    if (*next != ',') {
+                        return fail(parse_errc::expected_array_separator, position_, *next);
+                    }
+                    ++position_;
+                    skip_whitespace();
+                    if (peek() == ']') {
+                        return fail(parse_errc::trailing_comma_in_array, position_);
+                    }
+                }
+                break;
+            }
+            if (level.depth == level.base) {
+                return true;
+            }
         }
+    }
 
-        switch (*ch) {
-            case 'n': return parse_null();
+    template <bool Report>
+    [[nodiscard]] auto parse_scalar(char first) -> bool {
+        switch (first) {
+            case 'n': return parse_null<Report>();
             case 't':
-            case 'f': return parse_boolean();
-            case '"': return parse_string();
-            case '[': return parse_array();
-            case '{': return parse_object();
+            case 'f': return parse_boolean<Report>();
+            case '"': {
+                std::string_view text;
+                if (!parse_string<Report && decode_values>(text)) {
+                    return false;
+                }
+                recorder_.count(&parse_stats::strings);
+                if constexpr (Report) {
+                    handler_.on_string(text);
+                }
+                return true;
+            }
             case '-':
             case '0': case '1': case '2': case '3': case '4':
             case '5': case '6': case '7': case '8': case '9':
-                return parse_number();
+                return parse_number<Report>();
             default:
-                throw parse_exception{
-                    std::format("Unexpected character '{}'", *ch), 
-                    position_
-                };
+                return fail(parse_errc::unexpected_character, position_, first);
         }
     }
 
-    [[nodiscard]] auto parse_null() -> value {
+    template <bool Report>
+    [[nodiscard]] auto parse_null() -> bool {
         if (position_ + 4 > input_.size() || 
             input_.substr(position_, 4) != "null") {
-            throw parse_exception{"Invalid null literal", position_};
+            return fail(parse_errc::invalid_null, position_);
         }
         position_ += 4;
-        return value{null_type{}};
+        recorder_.count(&parse_stats::nulls);
+        if constexpr (Report) {
+            handler_.on_null();
+        }
+        return true;
     }
 
-    [[nodiscard]] auto parse_boolean() -> value {
+    template <bool Report>
+    [[nodiscard]] auto parse_boolean() -> bool {
         if (position_ + 4 <= input_.size() && 
             input_.substr(position_, 4) == "true") {
             position_ += 4;
-            return value{true};
+            recorder_.count(&parse_stats::booleans);
+            if constexpr (Report) {
+                handler_.on_bool(true);
+            }
+            return true;
         }
         
         if (position_ + 5 <= input_.size() && 
             input_.substr(position_, 5) == "false") {
             position_ += 5;
-            return value{false};
+            recorder_.count(&parse_stats::booleans);
+            if constexpr (Report) {
+                handler_.on_bool(false);
+            }
+            return true;
         }
         
-        throw parse_exception{"Invalid boolean literal", position_};
+        return fail(parse_errc::invalid_boolean, position_);
     }
 
-    [[nodiscard]] auto parse_number() -> value {
+    // Validates and converts in one pass: digits are accumulated while they
+    // are scanned, and only doubles outside the exact fast path or integers
+    // beyond int64_t read the text a second time.
+    template <bool Report>
+    [[nodiscard]] auto parse_number() -> bool {
+        [[maybe_unused]] const auto timer = recorder_.sample(&parse_stats::number_ns);
         const size_t start = position_;
-        
-        if (peek() == '-') {
-            ++position_;
+        const char* const first = input_.data() + position_;
+        const char* const last = input_.data() + input_.size();
+        const char* p = first;
+
+        const bool negative = *p == '-';
+        if (negative) {
+            ++p;
         }
-        bool has_decimal = false;
-        bool has_exponent = false;
-        
-        if (!peek() || !std::isdigit(*peek())) {
-            throw parse_exception{"Invalid number", start};
+        if (p == last || !detail::is_digit(*p)) {
+            return fail(parse_errc::invalid_number, start);
         }
 
-        if (*peek() == '0') {
-            ++position_;
+        uint64_t mantissa = 0;
+        const char* const digits = p;
+        if (*p == '0') {
+            ++p;
         } else {
-            while (peek() && std::isdigit(*peek())) {
-                ++position_;
+            p = detail::accumulate_digits(p, last, mantissa);
+        }
+        size_t digit_count = static_cast<size_t>(p - digits);
+
+        bool is_double = false;
+        int64_t exponent = 0;
+        if (p != last && *p == '.') {
+            is_double = true;
+            ++p;
+            if (p == last || !detail::is_digit(*p)) {
+                return fail(parse_errc::missing_fraction_digit, offset_of(p));
             }
+            const char* const fraction = p;
+            p = detail::accumulate_digits(p, last, mantissa);
+            exponent = -static_cast<int64_t>(p - fraction);
+            digit_count += static_cast<size_t>(p - fraction);
         }
 
-        if (peek() == '.') {
-            has_decimal = true;
-            ++position_;
-            
-            if (!peek() || !std::isdigit(*peek())) {
-                throw parse_exception{"Invalid number: expected digit after '.'", position_};
+        if (p != last && (*p == 'e' || *p == 'E')) {
+            is_double = true;
+            ++p;
+            bool negative_exponent = false;
+            if (p != last && (*p == '+' || *p == '-')) {
+                negative_exponent = *p == '-';
+                ++p;
             }
-            
-            while (peek() && std::isdigit(*peek())) {
-                ++position_;
+            if (p == last || !detail::is_digit(*p)) {
+                return fail(parse_errc::missing_exponent_digit, offset_of(p));
+            }
+            int64_t explicit_exponent = 0;
+            for (; p != last && detail::is_digit(*p); ++p) {
+                if (explicit_exponent < 100000) {
+                    explicit_exponent = explicit_exponent * 10 + (*p - '0');
+                }
             }
+            exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
         }
 
-        if (peek() == 'e' || peek() == 'E') {
-            has_exponent = true;
-            ++position_;
-            
-            if (peek() == '+' || peek() == '-') {
-                ++position_;
+        position_ = offset_of(p);
+
+        // Up to 19 digits always fit in the 64-bit accumulator.
+        const bool exact_mantissa = digit_count <= 19;
+
+        if (!is_double) {
+            constexpr auto max_magnitude = static_cast<uint64_t>(std::numeric_limits<integer_type>::max());
+            if (exact_mantissa && mantissa <= max_magnitude + (negative ? 1 : 0)) {
+                recorder_.count(&parse_stats::integers);
+                if constexpr (Report) {
+                    handler_.on_int(negative
+                        ? static_cast<integer_type>(0 - mantissa)
+                        : static_cast<integer_type>(mantissa));
+                }
+                return true;
             }
-            
-            if (!peek() || !std::isdigit(*peek())) {
-                throw parse_exception{"Invalid number: expected digit in exponent", position_};
+            switch (options_.big_integers) {
+                case big_integer_mode::error:
+                    return fail(parse_errc::integer_overflow, start);
+                case big_integer_mode::as_string:
+                    recorder_.count(&parse_stats::strings);
+                    if constexpr (Report) {
+                        handler_.on_string(std::string_view(first, static_cast<size_t>(p - first)));
+                    }
+                    return true;
+                case big_integer_mode::as_double:
+                    break;
             }
-            
-            while (peek() && std::isdigit(*peek())) {
-                ++position_;
+        }
+
+        if (exact_mantissa) {
+            if (const auto result = detail::exact_double(mantissa, exponent, negative)) {
+                recorder_.count(&parse_stats::doubles);
+                if constexpr (Report) {
+                    handler_.on_double(*result);
+                }
+                return true;
             }
         }
 
-        const auto number_str = input_.substr(start, position_ - start);
+        double result;
+        auto [ptr, ec] = std::from_chars(first, p, result);
+        if (ec != std::errc{}) {
+            return fail(parse_errc::number_out_of_range, start);
+        }
+        recorder_.count(&parse_stats::doubles);
+        if constexpr (Report) {
+            handler_.on_double(result);
+        }
+        return true;
+    }
+
+    [[nodiscard]] auto offset_of(const char* p) const noexcept -> size_t {
+        return static_cast<size_t>(p - input_.data());
+    }
+
+    [[nodiscard]] auto next_plain_run() const noexcept -> size_t {
+        return detail::plain_string_run(input_.data() + position_, input_.size() - position_);
+    }
+
+    // Sets out to a view into the input for escape-free strings and into
+    // the scratch buffer otherwise, or to an empty view when not Decode.
+    template <bool Decode = true>
+    [[nodiscard]] auto parse_string(std::string_view& out) -> bool {
+        [[maybe_unused]] const auto timer = recorder_.sample(&parse_stats::string_ns);
+        if (!expect('"')) {
+            return false;
+        }
+        const size_t start = position_;
         
-        if (has_decimal || has_exponent) {
-            double result;
-            auto [ptr, ec] = std::from_chars(
-                number_str.data(), 
-                number_str.data() + number_str.size(), 
-                result
-            );
-            
-            if (ec != std::errc{}) {
-                throw parse_exception{"Failed to parse number", start};
-            }
-            
-            return value{result};
+        const size_t run = next_plain_run();
+        if (position_ + run < input_.size() && input_[position_ + run] == '"') {
+            out = input_.substr(position_, run);
+            position_ += run + 1;
         } else {
-            int64_t result;
-            auto [ptr, ec] = std::from_chars(
-                number_str.data(), 
-                number_str.data() + number_str.size(), 
-                result
-            );
-            
-            if (ec != std::errc{}) {
-                throw parse_exception{"Failed to parse integer", start};
+            if (!decode_string<Decode>(run, out)) {
+                return false;
+            }
+            recorder_.count(&parse_stats::escaped_strings);
+        }
+        if (options_.validate_utf8) {
+            const std::string_view raw = input_.substr(start, position_ - 1 - start);
+            if (const size_t bad = detail::find_invalid_utf8(raw.data(), raw.size()); bad != raw.size()) {
+                return fail(parse_errc::invalid_utf8, start + bad);
             }
-            
-            return value{result};
         }
+        return true;
     }
 
-    [[nodiscard]] auto parse_string() -> value {
-        expect('"');
-        
-        std::string result;
-        result.reserve(32); 
+    // Appends decoded string bytes to the scratch buffer, unless only
+    // validating.
+    template <bool Decode>
+    auto put(std::string_view text) -> void {
+        if constexpr (Decode) {
+            scratch_.append(text);
+        }
+    }
+
+    template <bool Decode>
+    auto put(char ch) -> void {
+        if constexpr (Decode) {
+            scratch_.push_back(ch);
+        }
+    }
+
+    // Continues a string whose first `run` bytes after the opening quote are
+    // known to be plain.
+    template <bool Decode>
+    [[nodiscard]] auto decode_string(size_t run, std::string_view& out) -> bool {
+        scratch_.clear();
+        put<Decode>(input_.substr(position_, run));
+        position_ += run;
         
         while (true) {
             if (position_ >= input_.size()) {
-                throw parse_exception{"Unterminated string", position_};
+                return fail(parse_errc::unterminated_string, position_);
             }
             
             const char ch = input_[position_++];
@@ -213,24 +730,24 @@ private:
             
             if (ch == '\\') {
                 if (position_ >= input_.size()) {
-                    throw parse_exception{"Unterminated escape sequence", position_};
+                    return fail(parse_errc::unterminated_escape, position_);
                 }
                 
                 const char escaped = input_[position_++];
                 
                 switch (escaped) {
-                    case '"':  result += '"'; break;
-                    case '\\': result += '\\'; break;
-                    case '/':  result += '/'; break;
-                    case 'b':  result += '\b'; break;
-                    case 'f':  result += '\f'; break;
-                    case 'n':  result += '\n'; break;
-                    case 'r':  result += '\r'; break;
-                    case 't':  result += '\t'; break;
+                    case '"':  put<Decode>('"'); break;
+                    case '\\': put<Decode>('\\'); break;
+                    case '/':  put<Decode>('/'); break;
+                    case 'b':  put<Decode>('\b'); break;
+                    case 'f':  put<Decode>('\f'); break;
+                    case 'n':  put<Decode>('\n'); break;
+                    case 'r':  put<Decode>('\r'); break;
+                    case 't':  put<Decode>('\t'); break;
                     case 'u': {
 
                         if (position_ + 4 > input_.size()) {
-                            throw parse_exception{"Invalid unicode escape", position_};
+                            return fail(parse_errc::invalid_unicode_escape, position_);
                         }
                         
                         uint32_t codepoint = 0;
@@ -245,136 +762,294 @@ private:
                             } else if (hex >= 'A' && hex <= 'F') {
                                 codepoint |= (hex - 'A' + 10);
                             } else {
-                                throw parse_exception{"Invalid hex digit in unicode escape", position_ - 1};
+                                return fail(parse_errc::invalid_hex_digit, position_ - 1);
                             }
                         }
                         
                         if (codepoint <= 0x7F) {
-                            result += static_cast<char>(codepoint);
+                            put<Decode>(static_cast<char>(codepoint));
                         } else if (codepoint <= 0x7FF) {
-                            result += static_cast<char>(0xC0 | (codepoint >> 6));
-                            result += static_cast<char>(0x80 | (codepoint & 0x3F));
+                            put<Decode>(static_cast<char>(0xC0 | (codepoint >> 6)));
+                            put<Decode>(static_cast<char>(0x80 | (codepoint & 0x3F)));
                         } else {
-                            result += static_cast<char>(0xE0 | (codepoint >> 12));
-                            result += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
-                            result += static_cast<char>(0x80 | (codepoint & 0x3F));
+                            put<Decode>(static_cast<char>(0xE0 | (codepoint >> 12)));
+                            put<Decode>(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+                            put<Decode>(static_cast<char>(0x80 | (codepoint & 0x3F)));
                         }
                         break;
                     }
                     default:
-                        throw parse_exception{
-                            std::format("Invalid escape sequence '\\{}'", escaped), 
-                            position_ - 1
-                        };
+                        return fail(parse_errc::invalid_escape, position_ - 1, escaped);
                 }
-            } else if (static_cast<unsigned char>(ch) < 0x20) {
-                throw parse_exception{"Unescaped control character in string", position_ - 1};
             } else {
-                result += ch;
+                return fail(parse_errc::control_character, position_ - 1);
             }
+
+            run = next_plain_run();
+            put<Decode>(input_.substr(position_, run));
+            position_ += run;
         }
         
-        return value{std::move(result)};
+        out = scratch_;
+        return true;
     }
 
-    [[nodiscard]] auto parse_array() -> value {
-        expect('[');
-        skip_whitespace();
-        
-        array_type result;
-        
-        if (peek() == ']') {
-            ++position_;
-            return value{std::move(result)};
+    // Consumes the opening bracket of an array or object.
+    template <bool Report>
+    [[nodiscard]] auto open(nesting& level, bool object) -> bool {
+        if (level.depth >= options_.max_depth) {
+            return fail(parse_errc::depth_exceeded, position_);
         }
-        
-        while (true) {
-            result.push_back(parse_value());
-            skip_whitespace();
-            
-            const auto ch = peek();
-            if (!ch) {
-                throw parse_exception{"Unterminated array", position_};
+        if (level.depth > level.base) {
+            containers_.push(level.top);
+        }
+        level.top = { 0, object };
+        ++level.depth;
+        ++position_;
+        if (object) {
+            recorder_.enter(&parse_stats::objects);
+            if constexpr (Report) {
+                handler_.start_object();
             }
-            
-            if (*ch == ']') {
-                ++position_;
-                break;
+        } else {
+            recorder_.enter(&parse_stats::arrays);
+            if constexpr (Report) {
+                handler_.start_array();
             }
-            
-            if (*ch == ',') {
-                ++position_;
-                skip_whitespace();
-                
-                if (peek() == ']') {
-                    throw parse_exception{"Trailing comma in array", position_};
-                }
+        }
+        return true;
+    }
+
+    // Called once the closing bracket has been consumed.
+    template <bool Report>
+    auto close(nesting& level) -> void {
+        const open_container closed = level.top;
+        if (--level.depth > level.base) {
+            level.top = containers_.back();
+            containers_.pop();
+        }
+        recorder_.leave();
+        [[maybe_unused]] const auto timer = recorder_.sample(&parse_stats::build_ns);
+        if constexpr (Report) {
+            if (closed.object) {
+                handler_.end_object(closed.count);
             } else {
-                throw parse_exception{
-                    std::format("Expected ',' or ']', got '{}'", *ch), 
-                    position_
-                };
+                handler_.end_array(closed.count);
             }
         }
-        
-        return value{std::move(result)};
     }
 
-    [[nodiscard]] auto parse_object() -> value {
-        expect('{');
+    // Reads a member's key and the colon after it.
+    template <bool Report>
+    [[nodiscard]] auto parse_key() -> bool {
         skip_whitespace();
-        
-        object_type result;
-        
-        if (peek() == '}') {
-            ++position_;
-            return value{std::move(result)};
+        if (peek() != '"') {
+            return fail(parse_errc::expected_key, position_);
         }
-        
-        while (true) {
-            skip_whitespace();
-            
-            if (peek() != '"') {
-                throw parse_exception{"Expected string key in object", position_};
-            }
-            
-            auto key = parse_string().as_string();
-            
-            skip_whitespace();
-            expect(':');
-            skip_whitespace();
-            auto val = parse_value();
-            
-            result.emplace(std::move(key), std::move(val));
-            
-            skip_whitespace();
-            
-            const auto ch = peek();
-            if (!ch) {
-                throw parse_exception{"Unterminated object", position_};
-            }
-            
-            if (*ch == '}') {
-                ++position_;
-                break;
-            }
-            
-            if (*ch == ',') {
-                ++position_;
-                skip_whitespace();
-                
-                if (peek() == '}') {
-                    throw parse_exception{"Trailing comma in object", position_};
-                }
-            } else {
-                throw parse_exception{
-                    std::format("Expected ',' or '}}', got '{}'", *ch), 
-                    position_
-                };
+
+        std::string_view key;
+        if (!parse_string<Report && decode_keys>(key)) {
+            return false;
+        }
+        recorder_.count(&parse_stats::keys);
+        if constexpr (Report) {
+            handler_.on_key(key);
+        }
+
+        skip_whitespace();
+        return expect(':');
+    }
+};
+
+// Builds a value tree from parser events, allocating every container and
+// string from the given memory resource. Finished values wait on a flat
+// stack until their container closes, so each container is allocated once
+// at its final size.
+class dom_builder {
+public:
+    dom_builder(
+        std::string_view input,
+        std::pmr::memory_resource* resource,
+        bool borrow_strings,
+        key_table* keys = nullptr
+    ) noexcept
+        : input_{input}, resource_{resource}, borrow_strings_{borrow_strings}, key_table_{keys} {}
+
+    auto on_null() -> void { values_.emplace_back(null_type{}); }
+    auto on_bool(bool b) -> void { values_.emplace_back(b); }
+    auto on_int(integer_type i) -> void { values_.emplace_back(i); }
+    auto on_double(number_type n) -> void { values_.emplace_back(n); }
+
+    auto on_string(std::string_view text) -> void {
+        if (borrow_strings_ && points_into_input(text)) {
+            values_.push_back(value::borrowed(text));
+        } else {
+            values_.emplace_back(text, resource_);
+            if (text.size() > value::inline_string_capacity) {
+                allocations_.allocated(sizeof(detail::string_block) + text.size());
             }
         }
-        
-        return value{std::move(result)};
+    }
+
+    auto on_key(std::string_view text) -> void {
+        if (key_table_ != nullptr) {
+            keys_.push_back(key_table_->intern(text, resource_));
+        } else {
+            keys_.emplace_back(text, resource_);
+        }
+        if (text.size() > compact_string::inline_capacity && !keys_.back().is_interned()) {
+            allocations_.allocated(sizeof(detail::string_block) + text.size());
+        }
+    }
+
+    auto start_object() -> void {}
+
+    auto end_object(size_t count) -> void {
+        object_type result{ resource_ };
+        result.reserve(count);
+        const size_t first_key = keys_.size() - count;
+        const size_t first_value = values_.size() - count;
+        for (size_t i = 0; i < count; ++i) {
+            result.try_emplace(std::move(keys_[first_key + i]), std::move(values_[first_value + i]));
+        }
+        keys_.resize(first_key);
+        values_.resize(first_value);
+        allocations_.allocated(sizeof(detail::container_node<object_type>));
+        allocations_.allocated(result.buffer_bytes(), result.buffer_count());
+        values_.emplace_back(std::move(result));
+    }
+
+    auto start_array() -> void {}
+
+    auto end_array(size_t count) -> void {
+        array_type result(resource_);
+        result.reserve(count);
+        const size_t first = values_.size() - count;
+        for (size_t i = first; i < values_.size(); ++i) {
+            result.push_back(std::move(values_[i]));
+        }
+        values_.resize(first);
+        allocations_.allocated(sizeof(detail::container_node<array_type>));
+        allocations_.allocated(result.capacity() * sizeof(value), result.capacity() != 0 ? 1 : 0);
+        values_.emplace_back(std::move(result));
+    }
+
+    [[nodiscard]] auto release() -> value {
+        value root = std::move(values_.back());
+        values_.pop_back();
+        return root;
+    }
+
+#if JSONPP_DETAIL_STATS
+    // What building the tree has allocated so far, for parse_stats.
+    [[nodiscard]] auto allocation_stats() const noexcept -> const parse_stats& {
+        return allocations_.stats();
+    }
+#endif
+
+    // Prepares for another document, dropping whatever a failed parse left
+    // behind but keeping the capacity of the value and key stacks.
+    auto reset(
+        std::string_view input,
+        std::pmr::memory_resource* resource,
+        bool borrow_strings,
+        key_table* keys
+    ) noexcept -> void {
+        input_ = input;
+        resource_ = resource;
+        borrow_strings_ = borrow_strings;
+        key_table_ = keys;
+        discard();
+        allocations_.begin();
+    }
+
+    // Destroys whatever a failed parse left on the stacks. Those values were
+    // allocated from the resource of that parse, so this must run while it
+    // is still alive.
+    auto discard() noexcept -> void {
+        values_.clear();
+        keys_.clear();
+    }
+
+    [[nodiscard]] auto retained_bytes() const noexcept -> size_t {
+        return values_.capacity() * sizeof(value) + keys_.capacity() * sizeof(compact_string);
+    }
+
+    auto release_buffers() noexcept -> void {
+        std::vector<value>{}.swap(values_);
+        std::vector<compact_string>{}.swap(keys_);
+    }
+
+private:
+    std::string_view input_;
+    std::pmr::memory_resource* resource_;
+    bool borrow_strings_;
+    key_table* key_table_;
+    std::vector<value> values_;
+    std::vector<compact_string> keys_;
+    [[no_unique_address]] detail::parse_recorder allocations_;
+
+    [[nodiscard]] auto points_into_input(std::string_view text) const noexcept -> bool {
+        return std::less_equal<>{}(input_.data(), text.data()) &&
+               std::less_equal<>{}(text.data() + text.size(), input_.data() + input_.size());
+    }
+};
+
+class parser {
+public:
+    explicit parser(
+        std::string_view input,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    ) noexcept 
+        : input_{input}, resource_{resource} {}
+
+    parser(
+        std::string_view input,
+        const parse_options& options,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    ) noexcept
+        : input_{input}, resource_{resource}, options_{options} {}
+
+    [[nodiscard]] auto parse() -> value {
+        dom_builder builder{ input_, resource_, options_.borrow_strings, options_.keys };
+        basic_parser<dom_builder> grammar{ input_, builder, options_ };
+        grammar.parse();
+        keep_stats(grammar);
+        return builder.release();
+    }
+
+    [[nodiscard]] auto try_parse() -> std::expected<value, parse_error> {
+        dom_builder builder{ input_, resource_, options_.borrow_strings, options_.keys };
+        basic_parser<dom_builder> grammar{ input_, builder, options_ };
+        if (const auto result = grammar.try_parse(); !result) {
+            return std::unexpected{ result.error() };
+        }
+        keep_stats(grammar);
+        return builder.release();
+    }
+
+    // Counters of the last successful parse; all zero unless
+    // JSONPP_ENABLE_STATS is defined.
+    [[nodiscard]] auto stats() const noexcept -> parse_stats {
+#if JSONPP_DETAIL_STATS
+        return stats_;
+#else
+        return {};
+#endif
+    }
+
+private:
+    std::string_view input_;
+    std::pmr::memory_resource* resource_;
+    parse_options options_{};
+#if JSONPP_DETAIL_STATS
+    parse_stats stats_;
+#endif
+
+    auto keep_stats([[maybe_unused]] const basic_parser<dom_builder>& grammar) noexcept -> void {
+#if JSONPP_DETAIL_STATS
+        stats_ = grammar.stats();
+#endif
     }
 };
 
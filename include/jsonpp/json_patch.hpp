@@ -0,0 +1,301 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <span>
+#include <format>
+#include <utility>
+#include <algorithm>
+#include "json_value.hpp"
+#include "json_path.hpp"
+#include "json_exception.hpp"
+
+namespace jsonpp {
+
+namespace detail {
+
+// Appends "/token" to a JSON Pointer, escaping '~' as ~0 and '/' as ~1.
+inline auto append_pointer_token(std::string& pointer, std::string_view token) -> void {
+    pointer.push_back('/');
+    for (const char ch : token) {
+        if (ch == '~') {
+            pointer += "~0";
+        } else if (ch == '/') {
+            pointer += "~1";
+        } else {
+            pointer.push_back(ch);
+        }
+    }
+}
+
+// A hint for diff(): equal values hash alike, so a differing hash skips the
+// walk and equal hashes are confirmed by operator==. A hash left stale by a
+// write through an old reference can only answer false, which costs a
+// longer patch, never a wrong one, as compare() then descends both sides.
+[[nodiscard]] inline auto same_value(const value& lhs, const value& rhs) noexcept -> bool {
+    return lhs.hash() == rhs.hash() && lhs == rhs;
+}
+
+class patch_builder {
+public:
+    auto compare(const value& from, const value& to) -> void {
+        if (same_value(from, to)) {
+            return;
+        }
+        if (from.is_object() && to.is_object()) {
+            compare_objects(from.as_object(), to.as_object());
+        } else if (from.is_array() && to.is_array()) {
+            compare_arrays(from.as_array(), to.as_array());
+        } else {
+            emit("replace", path_, &to);
+        }
+    }
+
+    [[nodiscard]] auto release() -> value {
+        return std::move(operations_);
+    }
+
+private:
+    value operations_ = value(array_type{});
+    std::string path_;
+
+    auto emit(std::string_view op, std::string_view path, const value* val) -> void {
+        value operation(object_type{});
+        operation.reserve(val != nullptr ? 3 : 2);
+        operation.try_emplace("op", op);
+        operation.try_emplace("path", path);
+        if (val != nullptr) {
+            operation.try_emplace("value", *val);
+        }
+        operations_.push_back(std::move(operation));
+    }
+
+    // Runs body with token appended to the current path.
+    template <typename Body>
+    auto nested(std::string_view token, Body&& body) -> void {
+        const size_t length = path_.size();
+        append_pointer_token(path_, token);
+        body();
+        path_.resize(length);
+    }
+
+    template <typename Body>
+    auto nested_index(size_t index, Body&& body) -> void {
+        nested(std::format("{}", index), body);
+    }
+
+    auto compare_objects(const object_type& from, const object_type& to) -> void {
+        for (const auto& [key, member] : from) {
+            const auto it = to.find(key);
+            nested(key, [&] {
+                if (it == to.end()) {
+                    emit("remove", path_, nullptr);
+                } else {
+                    compare(member, it->second);
+                }
+            });
+        }
+        for (const auto& [key, member] : to) {
+            if (!from.contains(key)) {
+                nested(key, [&] { emit("add", path_, &member); });
+            }
+        }
+    }
+
+    // Skips the common prefix and suffix, so one element inserted or removed
+    // anywhere costs one operation; what is left in between is compared
+    // position by position.
+    auto compare_arrays(const array_type& from, const array_type& to) -> void {
+        size_t prefix = 0;
+        while (prefix < from.size() && prefix < to.size() && same_value(from[prefix], to[prefix])) {
+            ++prefix;
+        }
+        size_t suffix = 0;
+        while (suffix < from.size() - prefix && suffix < to.size() - prefix
+               && same_value(from[from.size() - 1 - suffix], to[to.size() - 1 - suffix])) {
+            ++suffix;
+        }
+
+        const size_t from_middle = from.size() - prefix - suffix;
+        const size_t to_middle = to.size() - prefix - suffix;
+        const size_t paired = std::min(from_middle, to_middle);
+        for (size_t i = prefix; i < prefix + paired; ++i) {
+            nested_index(i, [&] { compare(from[i], to[i]); });
+        }
+        for (size_t i = paired; i < from_middle; ++i) {
+            nested_index(prefix + paired, [&] { emit("remove", path_, nullptr); });
+        }
+        for (size_t i = prefix + paired; i < prefix + to_middle; ++i) {
+            nested_index(i, [&] { emit("add", path_, &to[i]); });
+        }
+    }
+};
+
+[[nodiscard]] inline auto patch_member(const value& operation, std::string_view name) -> const value& {
+    const value* member = operation.find(name);
+    if (member == nullptr) {
+        throw patch_exception{std::format("JSON Patch operation has no '{}'", name)};
+    }
+    return *member;
+}
+
+[[nodiscard]] inline auto patch_string(const value& operation, std::string_view name) -> std::string_view {
+    const value& member = patch_member(operation, name);
+    if (!member.is_string()) {
+        throw patch_exception{std::format("JSON Patch '{}' must be a string", name)};
+    }
+    return member.as_string();
+}
+
+// Follows steps from root. Walking through the non-const accessors drops
+// the cached hash of each container on the way.
+[[nodiscard]] inline auto patch_walk(value& root, std::span<const path_step> steps, std::string_view pointer)
+    -> value& {
+    value* node = &root;
+    for (const auto& step : steps) {
+        if (node->is_object()) {
+            node = node->find(step.key);
+        } else if (node->is_array() && step.index < node->size()) {
+            node = &(*node)[step.index];
+        } else {
+            node = nullptr;
+        }
+        if (node == nullptr) {
+            throw patch_exception{std::format("JSON Patch path '{}' does not exist", pointer)};
+        }
+    }
+    return *node;
+}
+
+// The value holding the last step, for operations that change it.
+[[nodiscard]] inline auto patch_parent(value& root, std::span<const path_step> steps, std::string_view pointer)
+    -> value& {
+    return patch_walk(root, steps.first(steps.size() - 1), pointer);
+}
+
+[[nodiscard]] inline auto patch_get(const value& root, std::string_view pointer) -> const value& {
+    const value* found = path::pointer(pointer).find(root);
+    if (found == nullptr) {
+        throw patch_exception{std::format("JSON Patch path '{}' does not exist", pointer)};
+    }
+    return *found;
+}
+
+inline auto patch_add(value& root, std::string_view pointer, value val) -> void {
+    const path location = path::pointer(pointer);
+    const auto steps = location.steps();
+    if (steps.empty()) {
+        root = std::move(val);
+        return;
+    }
+    value& parent = patch_parent(root, steps, pointer);
+    const path_step& last = steps.back();
+    if (parent.is_object()) {
+        parent.insert_or_assign(last.key, std::move(val));
+        return;
+    }
+    if (parent.is_array()) {
+        auto& elements = parent.as_array();
+        if (last.key == "-") {
+            elements.push_back(std::move(val));
+            return;
+        }
+        if (last.index <= elements.size()) {
+            elements.insert(elements.begin() + static_cast<std::ptrdiff_t>(last.index), std::move(val));
+            return;
+        }
+    }
+    throw patch_exception{std::format("JSON Patch path '{}' does not exist", pointer)};
+}
+
+inline auto patch_remove(value& root, std::string_view pointer) -> value {
+    const path location = path::pointer(pointer);
+    const auto steps = location.steps();
+    if (steps.empty()) {
+        return std::exchange(root, value{});
+    }
+    value& parent = patch_parent(root, steps, pointer);
+    const path_step& last = steps.back();
+    if (value* member = parent.find(last.key); member != nullptr) {
+        value removed = std::move(*member);
+        parent.as_object().erase(last.key);
+        return removed;
+    }
+    if (parent.is_array() && last.index < parent.size()) {
+        auto& elements = parent.as_array();
+        const auto it = elements.begin() + static_cast<std::ptrdiff_t>(last.index);
+        value removed = std::move(*it);
+        elements.erase(it);
+        return removed;
+    }
+    throw patch_exception{std::format("JSON Patch path '{}' does not exist", pointer)};
+}
+
+inline auto apply_operation(value& root, const value& operation) -> void {
+    if (!operation.is_object()) {
+        throw patch_exception{"JSON Patch operation must be an object"};
+    }
+    const std::string_view op = patch_string(operation, "op");
+    const std::string_view pointer = patch_string(operation, "path");
+
+    if (op == "add") {
+        patch_add(root, pointer, patch_member(operation, "value"));
+    } else if (op == "remove") {
+        (void)patch_remove(root, pointer);
+    } else if (op == "replace") {
+        value replacement = patch_member(operation, "value");
+        patch_walk(root, path::pointer(pointer).steps(), pointer) = std::move(replacement);
+    } else if (op == "move") {
+        const std::string_view from = patch_string(operation, "from");
+        if (pointer == from) {
+            (void)patch_get(root, from);
+            return;
+        }
+        if (pointer.starts_with(from) && pointer[from.size()] == '/') {
+            throw patch_exception{std::format("JSON Patch cannot move '{}' into itself", from)};
+        }
+        patch_add(root, pointer, patch_remove(root, from));
+    } else if (op == "copy") {
+        patch_add(root, pointer, patch_get(root, patch_string(operation, "from")));
+    } else if (op == "test") {
+        if (patch_get(root, pointer) != patch_member(operation, "value")) {
+            throw patch_exception{std::format("JSON Patch test failed at '{}'", pointer)};
+        }
+    } else {
+        throw patch_exception{std::format("Unknown JSON Patch operation '{}'", op)};
+    }
+}
+
+}
+
+// The RFC 6902 JSON Patch that turns from into to, as an array of
+// operations. Subtrees whose hashes match are confirmed equal and skipped
+// without emitting anything, and the hashes computed stay cached on both
+// trees, so diffing many versions against one base re-walks only what
+// changed.
+[[nodiscard]] inline auto diff(const value& from, const value& to) -> value {
+    detail::patch_builder builder;
+    builder.compare(from, to);
+    return builder.release();
+}
+
+// Applies an RFC 6902 JSON Patch in place and throws patch_exception if an
+// operation is malformed, names a missing location or fails its test. The
+// operations before the failing one stay applied; use patched() when the
+// target must be left untouched.
+inline auto apply_patch(value& target, const value& patch) -> void {
+    if (!patch.is_array()) {
+        throw patch_exception{"JSON Patch must be an array of operations"};
+    }
+    for (const auto& operation : patch.as_array()) {
+        detail::apply_operation(target, operation);
+    }
+}
+
+[[nodiscard]] inline auto patched(const value& target, const value& patch) -> value {
+    value result = target;
+    apply_patch(result, patch);
+    return result;
+}
+
+}
@@ -0,0 +1,507 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <span>
+#include <optional>
+#include <charconv>
+#include <cstdint>
+#include <format>
+#include "json_value.hpp"
+#include "json_parser.hpp"
+#include "json_tape.hpp"
+#include "json_exception.hpp"
+
+namespace jsonpp {
+
+// One step of a compiled path. A JSON Pointer token such as "0" may name an
+// object member or an array element, so it carries both a key and an index.
+struct path_step {
+    enum class kind : uint8_t { key, index, key_or_index, wildcard };
+
+    static constexpr size_t no_index = static_cast<size_t>(-1);
+
+    kind type = kind::key;
+    std::string key{};
+    size_t index = no_index;
+
+    [[nodiscard]] auto matches_key(std::string_view name) const noexcept -> bool {
+        return type == kind::wildcard || (type != kind::index && key == name);
+    }
+
+    [[nodiscard]] auto matches_index(size_t position) const noexcept -> bool {
+        return type == kind::wildcard || (type != kind::key && index == position);
+    }
+};
+
+// A path compiled once and evaluated many times. Two syntaxes are accepted:
+// RFC 6901 JSON Pointer ("/author/name", "/features/0") and a JSONPath
+// subset made of $, .name, ['name'], [n], .* and [*].
+class path {
+public:
+    path() = default;
+
+    // Expressions starting with '$' are JSONPath; everything else is a
+    // JSON Pointer.
+    explicit path(std::string_view expression)
+        : path(!expression.empty() && expression.front() == '$' ? jsonpath(expression) : pointer(expression)) {}
+
+    [[nodiscard]] static auto pointer(std::string_view expression) -> path {
+        path result;
+        if (expression.empty()) {
+            return result;
+        }
+        if (expression.front() != '/') {
+            throw parse_exception{"JSON Pointer must start with '/'", 0};
+        }
+
+        size_t position = 1;
+        while (true) {
+            const size_t end = std::min(expression.find('/', position), expression.size());
+            path_step step{ .type = path_step::kind::key_or_index };
+            for (size_t i = position; i < end; ++i) {
+                if (expression[i] != '~') {
+                    step.key.push_back(expression[i]);
+                } else if (i + 1 < end && (expression[i + 1] == '0' || expression[i + 1] == '1')) {
+                    step.key.push_back(expression[++i] == '0' ? '~' : '/');
+                } else {
+                    throw parse_exception{"Invalid escape in JSON Pointer", i};
+                }
+            }
+            step.index = array_index(step.key);
+            result.steps_.push_back(std::move(step));
+
+            if (end == expression.size()) {
+                return result;
+            }
+            position = end + 1;
+        }
+    }
+
+    [[nodiscard]] static auto jsonpath(std::string_view expression) -> path {
+        if (expression.empty() || expression.front() != '$') {
+            throw parse_exception{"JSONPath must start with '$'", 0};
+        }
+
+        path result;
+        size_t position = 1;
+        while (position < expression.size()) {
+            const char ch = expression[position];
+            if (ch == '.') {
+                ++position;
+                if (position < expression.size() && expression[position] == '*') {
+                    result.steps_.push_back({ .type = path_step::kind::wildcard });
+                    ++position;
+                    continue;
+                }
+                const size_t end = std::min(expression.find_first_of(".[", position), expression.size());
+                if (end == position) {
+                    throw parse_exception{"Expected a member name in JSONPath", position};
+                }
+                result.steps_.push_back({ .type = path_step::kind::key, .key = std::string{ expression.substr(position, end - position) } });
+                position = end;
+            } else if (ch == '[') {
+                position = result.parse_bracket(expression, position + 1);
+            } else {
+                throw parse_exception{std::format("Unexpected '{}' in JSONPath", ch), position};
+            }
+        }
+        return result;
+    }
+
+    [[nodiscard]] auto steps() const noexcept -> std::span<const path_step> {
+        return steps_;
+    }
+
+    // True when the path has no wildcard and so selects at most one value.
+    [[nodiscard]] auto is_singular() const noexcept -> bool {
+        for (const auto& step : steps_) {
+            if (step.type == path_step::kind::wildcard) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    [[nodiscard]] auto find(const value& root) const -> const value* {
+        const value* found = nullptr;
+        evaluate(root, 0, [&](const value& match) {
+            found = &match;
+            return true;
+        });
+        return found;
+    }
+
+    [[nodiscard]] auto select(const value& root) const -> std::vector<const value*> {
+        std::vector<const value*> found;
+        evaluate(root, 0, [&](const value& match) {
+            found.push_back(&match);
+            return false;
+        });
+        return found;
+    }
+
+    [[nodiscard]] auto find(const tape_value& root) const -> std::optional<tape_value> {
+        std::optional<tape_value> found;
+        evaluate(root, 0, [&](const tape_value& match) {
+            found = match;
+            return true;
+        });
+        return found;
+    }
+
+    [[nodiscard]] auto select(const tape_value& root) const -> std::vector<tape_value> {
+        std::vector<tape_value> found;
+        evaluate(root, 0, [&](const tape_value& match) {
+            found.push_back(match);
+            return false;
+        });
+        return found;
+    }
+
+    // Evaluates against unparsed JSON text and returns the raw text of each
+    // match. Defined after path_set, which does the work.
+    [[nodiscard]] auto select_raw(std::string_view json_text, const parse_options& options = {}) const
+        -> std::vector<std::string_view>;
+
+    [[nodiscard]] auto find_raw(std::string_view json_text, const parse_options& options = {}) const
+        -> std::optional<std::string_view>;
+
+private:
+    std::vector<path_step> steps_;
+
+    // RFC 6901 array index: "0" or digits without a leading zero.
+    [[nodiscard]] static auto array_index(std::string_view token) noexcept -> size_t {
+        if (token.empty() || (token.size() > 1 && token.front() == '0')) {
+            return path_step::no_index;
+        }
+        size_t index = 0;
+        const auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), index);
+        return error == std::errc{} && end == token.data() + token.size() ? index : path_step::no_index;
+    }
+
+    // Parses the inside of [...] starting after '['; returns the position
+    // after ']'.
+    auto parse_bracket(std::string_view expression, size_t position) -> size_t {
+        if (position >= expression.size()) {
+            throw parse_exception{"Unterminated '[' in JSONPath", position};
+        }
+
+        const char ch = expression[position];
+        if (ch == '*') {
+            steps_.push_back({ .type = path_step::kind::wildcard });
+            ++position;
+        } else if (ch == '\'' || ch == '"') {
+            path_step step{ .type = path_step::kind::key };
+            ++position;
+            while (position < expression.size() && expression[position] != ch) {
+                if (expression[position] == '\\' && position + 1 < expression.size()) {
+                    ++position;
+                }
+                step.key.push_back(expression[position++]);
+            }
+            if (position >= expression.size()) {
+                throw parse_exception{"Unterminated string in JSONPath", position};
+            }
+            ++position;
+            steps_.push_back(std::move(step));
+        } else {
+            const size_t end = std::min(expression.find(']', position), expression.size());
+            const size_t index = array_index(expression.substr(position, end - position));
+            if (index == path_step::no_index) {
+                throw parse_exception{"Expected an array index in JSONPath", position};
+            }
+            steps_.push_back({ .type = path_step::kind::index, .index = index });
+            position = end;
+        }
+
+        if (position >= expression.size() || expression[position] != ']') {
+            throw parse_exception{"Expected ']' in JSONPath", position};
+        }
+        return position + 1;
+    }
+
+    // Calls emit with every node the steps from step onward select below
+    // node; stops as soon as emit returns true.
+    template <typename Node, typename Emit>
+    auto evaluate(const Node& node, size_t step, Emit&& emit) const -> bool {
+        if (step == steps_.size()) {
+            return emit(node);
+        }
+
+        const path_step& current = steps_[step];
+        if (node.is_object()) {
+            if constexpr (std::is_same_v<Node, value>) {
+                if (current.type != path_step::kind::wildcard) {
+                    const auto& members = node.as_object();
+                    const auto it = members.find(current.key);
+                    return current.type != path_step::kind::index && it != members.end() &&
+                           evaluate(it->second, step + 1, emit);
+                }
+            }
+            for (auto&& [key, member] : node.as_object()) {
+                if (current.matches_key(key)) {
+                    if (evaluate(member, step + 1, emit)) {
+                        return true;
+                    }
+                    if (current.type != path_step::kind::wildcard) {
+                        return false;
+                    }
+                }
+            }
+        } else if (node.is_array()) {
+            if constexpr (std::is_same_v<Node, value>) {
+                if (current.type != path_step::kind::wildcard) {
+                    const auto& elements = node.as_array();
+                    return current.index < elements.size() && current.type != path_step::kind::key &&
+                           evaluate(elements[current.index], step + 1, emit);
+                }
+            }
+            size_t position = 0;
+            for (auto&& element : node.as_array()) {
+                if (current.matches_index(position)) {
+                    if (evaluate(element, step + 1, emit)) {
+                        return true;
+                    }
+                    if (current.type != path_step::kind::wildcard) {
+                        return false;
+                    }
+                }
+                ++position;
+            }
+        }
+        return false;
+    }
+};
+
+namespace detail {
+
+    // Walks JSON text once on behalf of several paths. The pull parser
+    // validates everything, but a subtree that no path can still match is
+    // skipped in place instead of being built; a subtree that a path
+    // selects is returned as a view of its text.
+    class raw_path_walker {
+    public:
+        raw_path_walker(
+            std::span<const path> paths,
+            std::string_view input,
+            const parse_options& options,
+            std::vector<std::vector<std::string_view>>& results
+        ) : paths_{ paths }, input_{ input }, reader_{ input, handler_, options }, results_{ results } {}
+
+        auto run() -> void {
+            results_.assign(paths_.size(), {});
+            for (size_t i = 0; i < paths_.size(); ++i) {
+                states_.push_back({ i, 0 });
+            }
+            reader_.start();
+            walk(0);
+            reader_.finish();
+        }
+
+    private:
+        // A path that has matched its first `step` steps at the current node.
+        struct state {
+            size_t path;
+            size_t step;
+        };
+
+        std::span<const path> paths_;
+        std::string_view input_;
+        null_handler handler_;
+        basic_parser<null_handler> reader_;
+        std::vector<std::vector<std::string_view>>& results_;
+        std::vector<state> states_;
+
+        [[nodiscard]] auto complete(const state& s) const noexcept -> bool {
+            return s.step == paths_[s.path].steps().size();
+        }
+
+        // Visits the value at the reader's position; states from first onward
+        // belong to it.
+        auto walk(size_t first) -> void {
+            const char ch = reader_.peek_token();
+            const size_t begin = reader_.position();
+
+            bool descend = false;
+            for (size_t i = first; i < states_.size(); ++i) {
+                descend = descend || !complete(states_[i]);
+            }
+
+            if (descend && ch == '{') {
+                walk_object(first);
+            } else if (descend && ch == '[') {
+                walk_array(first);
+            } else {
+                reader_.skip_value();
+            }
+
+            const std::string_view text = input_.substr(begin, reader_.position() - begin);
+            for (size_t i = first; i < states_.size(); ++i) {
+                if (complete(states_[i])) {
+                    results_[states_[i].path].push_back(text);
+                }
+            }
+        }
+
+        // Visits a child if any state continues into it, otherwise skips it.
+        template <typename Matches>
+        auto visit_child(size_t first, size_t last, Matches&& matches) -> void {
+            const size_t child_first = states_.size();
+            for (size_t i = first; i < last; ++i) {
+                const state s = states_[i];
+                if (!complete(s) && matches(paths_[s.path].steps()[s.step])) {
+                    states_.push_back({ s.path, s.step + 1 });
+                }
+            }
+            if (states_.size() == child_first) {
+                reader_.skip_value();
+            } else {
+                walk(child_first);
+                states_.resize(child_first);
+            }
+        }
+
+        auto walk_array(size_t first) -> void {
+            const size_t last = states_.size();
+            reader_.expect_token('[');
+            if (reader_.peek_token() == ']') {
+                reader_.expect_token(']');
+                return;
+            }
+
+            for (size_t index = 0;; ++index) {
+                visit_child(first, last, [&](const path_step& step) { return step.matches_index(index); });
+
+                const char ch = reader_.peek_token();
+                if (ch == ']') {
+                    reader_.expect_token(']');
+                    return;
+                }
+                if (ch != ',') {
+                    throw parse_exception{
+                        std::format("Expected ',' or ']', got '{}'", ch),
+                        reader_.position()
+                    };
+                }
+                reader_.expect_token(',');
+                if (reader_.peek_token() == ']') {
+                    throw parse_exception{"Trailing comma in array", reader_.position()};
+                }
+            }
+        }
+
+        auto walk_object(size_t first) -> void {
+            const size_t last = states_.size();
+            reader_.expect_token('{');
+            if (reader_.peek_token() == '}') {
+                reader_.expect_token('}');
+                return;
+            }
+
+            while (true) {
+                if (reader_.peek_token() != '"') {
+                    throw parse_exception{"Expected string key in object", reader_.position()};
+                }
+                const std::string_view key = reader_.read_string();
+                reader_.expect_token(':');
+                visit_child(first, last, [&](const path_step& step) { return step.matches_key(key); });
+
+                const char ch = reader_.peek_token();
+                if (ch == '}') {
+                    reader_.expect_token('}');
+                    return;
+                }
+                if (ch != ',') {
+                    throw parse_exception{
+                        std::format("Expected ',' or '}}', got '{}'", ch),
+                        reader_.position()
+                    };
+                }
+                reader_.expect_token(',');
+                if (reader_.peek_token() == '}') {
+                    throw parse_exception{"Trailing comma in object", reader_.position()};
+                }
+            }
+        }
+    };
+
+}
+
+// Several compiled paths evaluated together, so a document is traversed
+// once however many paths are asked of it.
+class path_set {
+public:
+    path_set() = default;
+
+    path_set(std::initializer_list<std::string_view> expressions) {
+        for (const auto expression : expressions) {
+            add(path{ expression });
+        }
+    }
+
+    // Returns the position of the path's results in what select() returns.
+    auto add(path p) -> size_t {
+        paths_.push_back(std::move(p));
+        return paths_.size() - 1;
+    }
+
+    [[nodiscard]] auto size() const noexcept -> size_t {
+        return paths_.size();
+    }
+
+    [[nodiscard]] auto operator[](size_t index) const noexcept -> const path& {
+        return paths_[index];
+    }
+
+    [[nodiscard]] auto select(const value& root) const -> std::vector<std::vector<const value*>> {
+        std::vector<std::vector<const value*>> results;
+        results.reserve(paths_.size());
+        for (const auto& p : paths_) {
+            results.push_back(p.select(root));
+        }
+        return results;
+    }
+
+    [[nodiscard]] auto select(const tape_value& root) const -> std::vector<std::vector<tape_value>> {
+        std::vector<std::vector<tape_value>> results;
+        results.reserve(paths_.size());
+        for (const auto& p : paths_) {
+            results.push_back(p.select(root));
+        }
+        return results;
+    }
+
+    // One pass over the text for all paths; results[i] holds the raw text
+    // of every match of path i, in document order.
+    [[nodiscard]] auto select_raw(std::string_view json_text, const parse_options& options = {}) const
+        -> std::vector<std::vector<std::string_view>> {
+        std::vector<std::vector<std::string_view>> results;
+        detail::raw_path_walker walker{ paths_, json_text, options, results };
+        walker.run();
+        return results;
+    }
+
+private:
+    std::vector<path> paths_;
+};
+
+inline auto path::select_raw(std::string_view json_text, const parse_options& options) const
+    -> std::vector<std::string_view> {
+    std::vector<std::vector<std::string_view>> results;
+    detail::raw_path_walker walker{ std::span<const path>{ this, 1 }, json_text, options, results };
+    walker.run();
+    return std::move(results.front());
+}
+
+inline auto path::find_raw(std::string_view json_text, const parse_options& options) const
+    -> std::optional<std::string_view> {
+    auto found = select_raw(json_text, options);
+    if (found.empty()) {
+        return std::nullopt;
+    }
+    return found.front();
+}
+
+}
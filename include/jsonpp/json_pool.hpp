@@ -0,0 +1,317 @@
+#pragma once
+
+#include <cstddef>
+#include <expected>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "json_value.hpp"
+#include "json_parser.hpp"
+#include "json_serializer.hpp"
+#include "json_describe.hpp"
+#include "json_document.hpp"
+#include "json_exception.hpp"
+
+namespace jsonpp {
+
+// Bytes of scratch memory a reusable parser or serializer keeps between
+// documents. Whatever grows past it for an outlier is released afterwards.
+inline constexpr size_t default_high_water_mark = size_t{ 1 } << 20;
+
+// A parser that survives across documents. Its string scratch buffer,
+// structural index and value stacks keep their capacity, so parsing a
+// stream of similar documents stops allocating anything but the trees
+// themselves; parse_into() reuses a document's arena as well.
+//
+// Not thread-safe: use one per thread, thread_parser() or a parser_pool.
+class reusable_parser {
+public:
+    explicit reusable_parser(const parse_options& options = {}, size_t high_water_mark = default_high_water_mark)
+        : options_{ options },
+          high_water_mark_{ high_water_mark } {}
+
+    reusable_parser(const reusable_parser&) = delete;
+    auto operator=(const reusable_parser&) -> reusable_parser& = delete;
+
+    [[nodiscard]] auto parse(
+        std::string_view input,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    ) -> value {
+        return parse(input, options_, resource);
+    }
+
+    [[nodiscard]] auto parse(
+        std::string_view input,
+        const parse_options& options,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    ) -> value {
+        auto result = try_parse(input, options, resource);
+        if (!result) {
+            throw parse_exception{ result.error() };
+        }
+        return std::move(*result);
+    }
+
+    [[nodiscard]] auto try_parse(
+        std::string_view input,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    ) -> std::expected<value, parse_error> {
+        return try_parse(input, options_, resource);
+    }
+
+    [[nodiscard]] auto try_parse(
+        std::string_view input,
+        const parse_options& options,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    ) -> std::expected<value, parse_error> {
+        builder_.reset(input, resource, options.borrow_strings, options.keys);
+        grammar_.reset(input, options);
+        // resource may be gone by the next call, as with parse_into() and a
+        // document that is then destroyed, so nothing built from it is kept
+        // past this one, whether it returns or throws.
+        struct discard_on_exit {
+            dom_builder& builder;
+            ~discard_on_exit() { builder.discard(); }
+        } guard{ builder_ };
+        std::expected<value, parse_error> outcome;
+        if (const auto result = grammar_.try_parse(); result) {
+            outcome = builder_.release();
+        } else {
+            outcome = std::unexpected{ result.error() };
+        }
+        trim();
+        return outcome;
+    }
+
+    // Replaces the tree held by doc, rewinding its arena rather than
+    // allocating a new one. The arena is capped at the high-water mark.
+    auto parse_into(std::string_view input, document& doc) -> value& {
+        doc.clear(high_water_mark_);
+        doc.root() = parse(input, doc.resource());
+        return doc.root();
+    }
+
+    [[nodiscard]] auto options() const noexcept -> const parse_options& {
+        return options_;
+    }
+
+    [[nodiscard]] auto high_water_mark() const noexcept -> size_t {
+        return high_water_mark_;
+    }
+
+    auto set_high_water_mark(size_t bytes) noexcept -> void {
+        high_water_mark_ = bytes;
+        trim();
+    }
+
+    // Counters of the last successful parse; all zero unless
+    // JSONPP_ENABLE_STATS is defined.
+    [[nodiscard]] auto stats() const noexcept -> parse_stats {
+        return grammar_.stats();
+    }
+
+    // Scratch memory currently kept for the next document.
+    [[nodiscard]] auto retained_bytes() const noexcept -> size_t {
+        return grammar_.retained_bytes() + builder_.retained_bytes();
+    }
+
+    auto release_memory() noexcept -> void {
+        grammar_.release_buffers();
+        builder_.release_buffers();
+    }
+
+private:
+    parse_options options_;
+    size_t high_water_mark_;
+    dom_builder builder_{ {}, std::pmr::get_default_resource(), false };
+    basic_parser<dom_builder> grammar_{ {}, builder_ };
+
+    auto trim() noexcept -> void {
+        if (retained_bytes() > high_water_mark_) {
+            release_memory();
+        }
+    }
+};
+
+// A serializer that writes into a buffer it keeps, so repeated calls reuse
+// the buffer's capacity instead of growing a fresh string each time.
+class reusable_serializer {
+public:
+    explicit reusable_serializer(bool pretty = false, size_t high_water_mark = default_high_water_mark)
+        : pretty_{ pretty },
+          high_water_mark_{ high_water_mark } {}
+
+    // The view stays valid until the next call.
+    [[nodiscard]] auto serialize(const value& val) -> std::string_view {
+        prepare();
+        serializer{ pretty_ }.serialize_to(val, buffer_);
+        return buffer_;
+    }
+
+    template <described T>
+    [[nodiscard]] auto serialize(const T& object) -> std::string_view {
+        prepare();
+        serializer{ pretty_ }.serialize_to(object, buffer_);
+        return buffer_;
+    }
+
+    // Same as serialize() but returns an owned copy, allocated once at its
+    // final size.
+    template <typename T>
+    [[nodiscard]] auto to_string(const T& object) -> std::string {
+        return std::string{ serialize(object) };
+    }
+
+    [[nodiscard]] auto high_water_mark() const noexcept -> size_t {
+        return high_water_mark_;
+    }
+
+    // A buffer already past the new mark is released by the next call.
+    auto set_high_water_mark(size_t bytes) noexcept -> void {
+        high_water_mark_ = bytes;
+    }
+
+    [[nodiscard]] auto retained_bytes() const noexcept -> size_t {
+        return buffer_.capacity();
+    }
+
+    // Invalidates the view returned by the last call.
+    auto release_memory() noexcept -> void {
+        std::string{}.swap(buffer_);
+    }
+
+private:
+    bool pretty_;
+    size_t high_water_mark_;
+    std::string buffer_;
+
+    // The buffer of an outlier can only be dropped once its view is dead,
+    // which is at the start of the following call.
+    auto prepare() noexcept -> void {
+        if (buffer_.capacity() > high_water_mark_) {
+            release_memory();
+        }
+        buffer_.clear();
+    }
+};
+
+// Parser of the calling thread, created on first use with default options.
+[[nodiscard]] inline auto thread_parser() -> reusable_parser& {
+    thread_local reusable_parser instance;
+    return instance;
+}
+
+[[nodiscard]] inline auto thread_serializer() -> reusable_serializer& {
+    thread_local reusable_serializer instance;
+    return instance;
+}
+
+// Parsers shared by any number of threads, for code that migrates between
+// threads (coroutines, work stealing) where thread_parser() does not fit.
+// acquire() lends an idle parser, or makes a new one when none is idle;
+// returned parsers beyond max_idle are destroyed.
+class parser_pool {
+public:
+    class lease {
+    public:
+        lease(lease&& other) noexcept
+            : pool_{ std::exchange(other.pool_, nullptr) },
+              parser_{ std::move(other.parser_) } {}
+
+        lease(const lease&) = delete;
+        auto operator=(const lease&) -> lease& = delete;
+        auto operator=(lease&&) -> lease& = delete;
+
+        ~lease() {
+            if (pool_ != nullptr) {
+                pool_->give_back(std::move(parser_));
+            }
+        }
+
+        [[nodiscard]] auto operator*() const noexcept -> reusable_parser& {
+            return *parser_;
+        }
+
+        [[nodiscard]] auto operator->() const noexcept -> reusable_parser* {
+            return parser_.get();
+        }
+
+    private:
+        friend class parser_pool;
+
+        parser_pool* pool_;
+        std::unique_ptr<reusable_parser> parser_;
+
+        lease(parser_pool* pool, std::unique_ptr<reusable_parser> parser) noexcept
+            : pool_{ pool },
+              parser_{ std::move(parser) } {}
+    };
+
+    explicit parser_pool(
+        const parse_options& options = {},
+        size_t max_idle = 64,
+        size_t high_water_mark = default_high_water_mark
+    )
+        : options_{ options },
+          max_idle_{ max_idle },
+          high_water_mark_{ high_water_mark } {}
+
+    parser_pool(const parser_pool&) = delete;
+    auto operator=(const parser_pool&) -> parser_pool& = delete;
+
+    // The pool must outlive the lease.
+    [[nodiscard]] auto acquire() -> lease {
+        {
+            std::lock_guard lock{ mutex_ };
+            if (!idle_.empty()) {
+                auto parser = std::move(idle_.back());
+                idle_.pop_back();
+                return lease{ this, std::move(parser) };
+            }
+        }
+        return lease{ this, std::make_unique<reusable_parser>(options_, high_water_mark_) };
+    }
+
+    [[nodiscard]] auto parse(std::string_view input) -> value {
+        return acquire()->parse(input);
+    }
+
+    [[nodiscard]] auto try_parse(std::string_view input) -> std::expected<value, parse_error> {
+        return acquire()->try_parse(input);
+    }
+
+    [[nodiscard]] auto idle() const -> size_t {
+        std::lock_guard lock{ mutex_ };
+        return idle_.size();
+    }
+
+    // Destroys every idle parser; parsers on loan are unaffected.
+    auto release_memory() -> void {
+        std::vector<std::unique_ptr<reusable_parser>> dropped;
+        std::lock_guard lock{ mutex_ };
+        dropped.swap(idle_);
+    }
+
+private:
+    parse_options options_;
+    size_t max_idle_;
+    size_t high_water_mark_;
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<reusable_parser>> idle_;
+
+    auto give_back(std::unique_ptr<reusable_parser> parser) noexcept -> void {
+        std::lock_guard lock{ mutex_ };
+        if (idle_.size() < max_idle_) {
+            try {
+                idle_.push_back(std::move(parser));
+            } catch (...) {
+            }
+        }
+    }
+};
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include "json_simd.hpp"
+
+namespace jsonpp {
+
+namespace detail {
+
+    // Marks the bytes escaped by a backslash, carrying odd-length backslash
+    // runs into the next block.
+    [[nodiscard]] inline auto find_escaped(uint64_t backslash, uint64_t& carry) noexcept -> uint64_t {
+        constexpr uint64_t even_bits = 0x5555555555555555ULL;
+
+        backslash &= ~carry;
+        const uint64_t follows_escape = (backslash << 1) | carry;
+        const uint64_t odd_starts = backslash & ~even_bits & ~follows_escape;
+        const uint64_t sum = odd_starts + backslash;
+        carry = sum < odd_starts ? 1 : 0;
+        const uint64_t invert_mask = sum << 1;
+        return (even_bits ^ invert_mask) & follows_escape;
+    }
+
+}
+
+// Stage-one pass over the input: records the offset of every structural
+// character outside strings, every opening quote and the first byte of every
+// literal or number. The parser jumps between these offsets instead of
+// skipping whitespace byte by byte.
+class structural_index {
+public:
+    static constexpr size_t max_input_size = std::numeric_limits<uint32_t>::max();
+
+    // Returns false when the input cannot be indexed (too large) or ends inside
+    // a string; the offsets collected so far are still usable in that case.
+    auto build(std::string_view input) -> bool {
+        offsets_.clear();
+        if (input.size() > max_input_size) {
+            return false;
+        }
+        offsets_.reserve(input.size() / 8 + 8);
+
+        state state{};
+        size_t offset = 0;
+        for (; offset + detail::simd_block::size <= input.size(); offset += detail::simd_block::size) {
+            scan_block(detail::simd_block::load(input.data() + offset), offset, state);
+        }
+        if (offset < input.size()) {
+            scan_block(detail::simd_block::load_partial(input.data() + offset, input.size() - offset, ' '),
+                       offset, state);
+        }
+        return state.in_string == 0;
+    }
+
+    auto clear() noexcept -> void {
+        offsets_.clear();
+    }
+
+    [[nodiscard]] auto size() const noexcept -> size_t {
+        return offsets_.size();
+    }
+
+    [[nodiscard]] auto empty() const noexcept -> bool {
+        return offsets_.empty();
+    }
+
+    [[nodiscard]] auto operator[](size_t i) const noexcept -> uint32_t {
+        return offsets_[i];
+    }
+
+    [[nodiscard]] auto offsets() const noexcept -> const std::vector<uint32_t>& {
+        return offsets_;
+    }
+
+    [[nodiscard]] auto capacity_bytes() const noexcept -> size_t {
+        return offsets_.capacity() * sizeof(uint32_t);
+    }
+
+    auto shrink() noexcept -> void {
+        std::vector<uint32_t>{}.swap(offsets_);
+    }
+
+private:
+    std::vector<uint32_t> offsets_;
+
+    struct state {
+        uint64_t escaped_carry = 0;
+        uint64_t in_string = 0;
+        uint64_t scalar_carry = 0;
+    };
+
+    auto scan_block(const detail::simd_block& block, size_t base, state& st) -> void {
+        const uint64_t escaped = detail::find_escaped(block.eq('\\'), st.escaped_carry);
+        const uint64_t quotes = block.eq('"') & ~escaped;
+
+        const uint64_t in_string = detail::prefix_xor(quotes) ^ st.in_string;
+        st.in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+
+        const uint64_t operators = block.eq('{') | block.eq('}') | block.eq('[') |
+                                   block.eq(']') | block.eq(':') | block.eq(',');
+        const uint64_t whitespace = block.eq(' ') | block.eq('\t') | block.eq('\n') | block.eq('\r');
+
+        const uint64_t scalar = ~(operators | whitespace | quotes) & ~in_string;
+        const uint64_t scalar_starts = scalar & ~((scalar << 1) | st.scalar_carry);
+        st.scalar_carry = scalar >> 63;
+
+        uint64_t bits = (operators & ~in_string) | (quotes & in_string) | scalar_starts;
+        while (bits != 0) {
+            offsets_.push_back(static_cast<uint32_t>(base + static_cast<size_t>(std::countr_zero(bits))));
+            bits &= bits - 1;
+        }
+    }
+};
+
+}
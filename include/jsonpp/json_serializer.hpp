@@ -1,12 +1,34 @@
 #pragma once
 
 #include <string>
-#include <sstream>
-#include <iomanip>
+#include <string_view>
+#include <vector>
+#include <charconv>
+#include <concepts>
+#include <cmath>
+#include <ranges>
+#include <type_traits>
 #include "json_value.hpp"
+#include "json_simd.hpp"
+#include "json_describe.hpp"
+#include "json_stats.hpp"
+#include "json_stack.hpp"
+#include "json_exception.hpp"
 
 namespace jsonpp {
 
+    // A contiguous character container the serializer appends to, such as
+    // std::string or std::vector<char>.
+    template <typename Buffer>
+    concept output_buffer = requires(Buffer& out, const char* text, size_t count) {
+        out.push_back('x');
+        out.insert(out.end(), text, text + count);
+        out.insert(out.end(), count, ' ');
+    };
+
+    template <output_buffer Buffer>
+    class writer;
+
     class serializer {
     public:
         explicit serializer(bool pretty = false, size_t indent_size = 2) noexcept
@@ -14,163 +36,340 @@ namespace jsonpp {
         }
 
         [[nodiscard]] auto serialize(const value& val) -> std::string {
-            std::ostringstream oss;
-            serialize_value(oss, val);
-            return oss.str();
+            std::string out;
+            serialize_to(val, out);
+            return out;
+        }
+
+        // Appends the JSON text of val to out. Callers that clear and reuse the
+        // same buffer avoid reallocating it on every call.
+        template <output_buffer Buffer>
+        auto serialize_to(const value& val, Buffer& out) -> void {
+            const size_t before = output_size(out);
+            recorder_.begin();
+            current_indent_ = 0;
+            containers_.truncate(0);
+            serialize_value(out, val);
+            recorder_.finish(output_size(out) - before);
+        }
+
+        // Writes a JSONPP_DESCRIBE'd type directly, without building a value.
+        template <described T>
+        [[nodiscard]] auto serialize(const T& object) -> std::string {
+            std::string out;
+            serialize_to(object, out);
+            return out;
+        }
+
+        template <described T, output_buffer Buffer>
+        auto serialize_to(const T& object, Buffer& out) -> void {
+            const size_t before = output_size(out);
+            recorder_.begin();
+            current_indent_ = 0;
+            containers_.truncate(0);
+            serialize_struct(out, object);
+            recorder_.finish(output_size(out) - before);
+        }
+
+        // Counters of the last serialize() or serialize_to() call; all zero
+        // unless JSONPP_ENABLE_STATS is defined.
+        [[nodiscard]] auto stats() const noexcept -> serialize_stats {
+            return recorder_.stats();
         }
 
     private:
+        template <output_buffer>
+        friend class writer;
+
         bool pretty_;
         size_t indent_size_;
         size_t current_indent_;
+        [[no_unique_address]] detail::serialize_recorder recorder_;
+
+        // The rest of a non-empty array or object being written: elements
+        // for an array, members for an object, the other pair empty.
+        struct open_container {
+            const value* next_element;
+            const value* end_element;
+            object_type::const_iterator next_member;
+            object_type::const_iterator end_member;
+        };
+
+        detail::inline_stack<open_container, 32> containers_;
+
+        template <output_buffer Buffer>
+        [[nodiscard]] static auto output_size(const Buffer& out) noexcept -> size_t {
+            if constexpr (stats_enabled && requires { out.size(); }) {
+                return out.size();
+            } else {
+                return 0;
+            }
+        }
 
-        auto write_indent(std::ostringstream& oss) const -> void {
-            if (pretty_) {
-                oss << std::string(current_indent_ * indent_size_, ' ');
+        template <output_buffer Buffer>
+        static auto write(Buffer& out, std::string_view text) -> void {
+            if constexpr (requires { out.append(text.data(), text.size()); }) {
+                out.append(text.data(), text.size());
+            } else {
+                out.insert(out.end(), text.data(), text.data() + text.size());
             }
         }
 
-        auto write_newline(std::ostringstream& oss) const -> void {
+        template <output_buffer Buffer>
+        auto write_indent(Buffer& out) const -> void {
             if (pretty_) {
-                oss << '\n';
+                out.insert(out.end(), current_indent_ * indent_size_, ' ');
             }
         }
 
-        auto write_space(std::ostringstream& oss) const -> void {
+        template <output_buffer Buffer>
+        auto write_newline(Buffer& out) const -> void {
             if (pretty_) {
-                oss << ' ';
+                out.push_back('\n');
             }
         }
 
-        auto serialize_value(std::ostringstream& oss, const value& val) -> void {
-            switch (val.type()) {
-            case value_type::null:
-                oss << "null";
-                break;
-
-            case value_type::boolean:
-                oss << (val.as_boolean() ? "true" : "false");
-                break;
-
-            case value_type::integer:
-                oss << val.as_integer();
-                break;
+        template <output_buffer Buffer>
+        auto write_space(Buffer& out) const -> void {
+            if (pretty_) {
+                out.push_back(' ');
+            }
+        }
 
-            case value_type::number:
-                serialize_number(oss, val.as_number());
-                break;
+        // Walks the tree with containers_ instead of recursing, so the depth
+        // of a value costs no native stack.
+        template <output_buffer Buffer>
+        auto serialize_value(Buffer& out, const value& val) -> void {
+            const size_t base = containers_.size();
+            const value* current = &val;
+            while (current != nullptr) {
+                recorder_.count_value();
+                switch (current->type()) {
+                    case value_type::null: write(out, "null"); break;
+                    case value_type::boolean: write(out, current->as_boolean() ? "true" : "false"); break;
+                    case value_type::integer: serialize_integer(out, current->as_integer()); break;
+                    case value_type::number: serialize_number(out, current->as_number()); break;
+                    case value_type::string: serialize_string(out, current->as_string()); break;
+                    case value_type::array:
+                        if (const auto& arr = current->as_array(); !arr.empty()) {
+                            out.push_back('[');
+                            write_newline(out);
+                            ++current_indent_;
+                            write_indent(out);
+                            containers_.push({ arr.data() + 1, arr.data() + arr.size(), {}, {} });
+                            current = arr.data();
+                            continue;
+                        }
+                        write(out, "[]");
+                        break;
+                    case value_type::object:
+                        if (const auto& obj = current->as_object(); !obj.empty()) {
+                            out.push_back('{');
+                            write_newline(out);
+                            ++current_indent_;
+                            containers_.push({ nullptr, nullptr, obj.begin() + 1, obj.end() });
+                            current = &serialize_member_key(out, *obj.begin());
+                            continue;
+                        }
+                        write(out, "{}");
+                        break;
+                }
 
-            case value_type::string:
-                serialize_string(oss, val.as_string());
-                break;
+                current = nullptr;
+                while (containers_.size() > base) {
+                    open_container& top = containers_.back();
+                    if (top.next_element != top.end_element) {
+                        out.push_back(',');
+                        write_newline(out);
+                        write_indent(out);
+                        current = top.next_element++;
+                        break;
+                    }
+                    if (top.next_member != top.end_member) {
+                        out.push_back(',');
+                        write_newline(out);
+                        current = &serialize_member_key(out, *top.next_member++);
+                        break;
+                    }
+                    const bool object = top.end_element == nullptr;
+                    containers_.pop();
+                    --current_indent_;
+                    write_newline(out);
+                    write_indent(out);
+                    out.push_back(object ? '}' : ']');
+                }
+            }
+        }
 
-            case value_type::array:
-                serialize_array(oss, val.as_array());
-                break;
+        // Writes an indented key and its colon; returns the member's value.
+        template <output_buffer Buffer>
+        auto serialize_member_key(Buffer& out, object_type::const_iterator::reference member) -> const value& {
+            write_indent(out);
+            serialize_string(out, member.first);
+            out.push_back(':');
+            write_space(out);
+            return member.second;
+        }
 
-            case value_type::object:
-                serialize_object(oss, val.as_object());
-                break;
-            }
+        template <output_buffer Buffer, std::integral Integer>
+        static auto serialize_integer(Buffer& out, Integer num) -> void {
+            char buffer[24];
+            const auto result = std::to_chars(buffer, buffer + sizeof(buffer), num);
+            write(out, std::string_view(buffer, static_cast<size_t>(result.ptr - buffer)));
         }
 
-        auto serialize_number(std::ostringstream& oss, double num) const -> void {
+        // Integral values in the int64 range are written without a fraction;
+        // everything else gets the shortest text that parses back to num. The
+        // range is checked before the cast, which is undefined outside it.
+        template <output_buffer Buffer, std::floating_point Number>
+        static auto serialize_number(Buffer& out, Number num) -> void {
+            constexpr Number int64_bound = 0x1p63;
+            if (num >= -int64_bound && num < int64_bound) {
+                const auto integral = static_cast<int64_t>(num);
+                if (static_cast<Number>(integral) == num) {
+                    serialize_integer(out, integral);
+                    return;
+                }
+            }
 
-            if (num == static_cast<int64_t>(num) &&
-                num >= std::numeric_limits<int64_t>::min() &&
-                num <= std::numeric_limits<int64_t>::max()) {
-                oss << static_cast<int64_t>(num);
+            // Every path that writes JSON text ends here, so none can emit
+            // the inf or nan that parse() would reject.
+            if (!std::isfinite(num)) {
+                throw json_exception{"Infinity and NaN have no JSON representation"};
             }
-            else
-            {
-                oss << std::setprecision(17) << num;
+
+            char buffer[32];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), num);
+            const std::string_view text(buffer, static_cast<size_t>(result.ptr - buffer));
+            if (text.find_first_of(".en") == std::string_view::npos) {
+                // Beyond the int64 range the fixed form may be chosen, which
+                // would read back as an out-of-range integer.
+                result = std::to_chars(buffer, buffer + sizeof(buffer), num, std::chars_format::scientific);
             }
+            write(out, std::string_view(buffer, static_cast<size_t>(result.ptr - buffer)));
         }
 
-        auto serialize_string(std::ostringstream& oss, const std::string& str) const -> void {
-            oss << '"';
+        template <output_buffer Buffer>
+        static auto serialize_string(Buffer& out, std::string_view str) -> void {
+            out.push_back('"');
+
+            size_t position = 0;
+            while (position < str.size()) {
+                const size_t run = detail::plain_string_run(str.data() + position, str.size() - position);
+                write(out, str.substr(position, run));
+                position += run;
+                if (position >= str.size()) {
+                    break;
+                }
 
-            for (char ch : str) {
+                const char ch = str[position++];
                 switch (ch) {
-                case '"':  oss << "\\\""; break;
-                case '\\': oss << "\\\\"; break;
-                case '\b': oss << "\\b"; break;
-                case '\f': oss << "\\f"; break;
-                case '\n': oss << "\\n"; break;
-                case '\r': oss << "\\r"; break;
-                case '\t': oss << "\\t"; break;
-                default:
-                    if (static_cast<unsigned char>(ch) < 0x20) {
-                        oss << "\\u"
-                            << std::hex << std::setfill('0') << std::setw(4)
-                            << static_cast<int>(static_cast<unsigned char>(ch))
-                            << std::dec;
-                    }
-                    else {
-                        oss << ch;
-                    }
+                case '"':  write(out, "\\\""); break;
+                case '\\': write(out, "\\\\"); break;
+                case '\b': write(out, "\\b"); break;
+                case '\f': write(out, "\\f"); break;
+                case '\n': write(out, "\\n"); break;
+                case '\r': write(out, "\\r"); break;
+                case '\t': write(out, "\\t"); break;
+                default: {
+                    constexpr char hex[] = "0123456789abcdef";
+                    const auto code = static_cast<unsigned char>(ch);
+                    const char escape[] = { '\\', 'u', '0', '0', hex[code >> 4], hex[code & 0xF] };
+                    write(out, std::string_view(escape, sizeof(escape)));
                     break;
                 }
+                }
             }
 
-            oss << '"';
+            out.push_back('"');
         }
 
-        auto serialize_array(std::ostringstream& oss, const array_type& arr) -> void {
-            oss << '[';
+        template <output_buffer Buffer, described T>
+        auto serialize_struct(Buffer& out, const T& object) -> void {
+            recorder_.count_value();
+            out.push_back('{');
 
-            if (!arr.empty()) {
-                write_newline(oss);
+            if constexpr (detail::field_table<T>::size != 0) {
+                write_newline(out);
                 ++current_indent_;
 
                 bool first = true;
-                for (const auto& element : arr) {
-                    if (!first) {
-                        oss << ',';
-                        write_newline(oss);
-                    }
-                    first = false;
-
-                    write_indent(oss);
-                    serialize_value(oss, element);
-                }
+                std::apply([&](const auto&... field) {
+                    ([&] {
+                        if (!first) {
+                            out.push_back(',');
+                            write_newline(out);
+                        }
+                        first = false;
+
+                        write_indent(out);
+                        serialize_string(out, field.name);
+                        out.push_back(':');
+                        write_space(out);
+                        serialize_member(out, object.*field.pointer);
+                    }(), ...);
+                }, detail::field_table<T>::fields);
 
                 --current_indent_;
-                write_newline(oss);
-                write_indent(oss);
+                write_newline(out);
+                write_indent(out);
             }
 
-            oss << ']';
+            out.push_back('}');
         }
 
-        auto serialize_object(std::ostringstream& oss, const object_type& obj) -> void {
-            oss << '{';
-
-            if (!obj.empty()) {
-                write_newline(oss);
-                ++current_indent_;
-
-                bool first = true;
-                for (const auto& [key, val] : obj) {
-                    if (!first) {
-                        oss << ',';
-                        write_newline(oss);
+        template <output_buffer Buffer, typename Member>
+        auto serialize_member(Buffer& out, const Member& member) -> void {
+            if constexpr (!std::is_same_v<Member, value> && !detail::is_optional_v<Member> && !described<Member>) {
+                recorder_.count_value();
+            }
+            if constexpr (std::is_same_v<Member, value>) {
+                serialize_value(out, member);
+            } else if constexpr (std::is_same_v<Member, bool>) {
+                write(out, member ? "true" : "false");
+            } else if constexpr (std::is_integral_v<Member>) {
+                serialize_integer(out, member);
+            } else if constexpr (std::is_floating_point_v<Member>) {
+                serialize_number(out, member);
+            } else if constexpr (std::is_convertible_v<const Member&, std::string_view>) {
+                serialize_string(out, member);
+            } else if constexpr (detail::is_optional_v<Member>) {
+                if (member) {
+                    serialize_member(out, *member);
+                } else {
+                    recorder_.count_value();
+                    write(out, "null");
+                }
+            } else if constexpr (described<Member>) {
+                serialize_struct(out, member);
+            } else if constexpr (std::ranges::input_range<Member>) {
+                out.push_back('[');
+
+                if (!std::ranges::empty(member)) {
+                    write_newline(out);
+                    ++current_indent_;
+
+                    bool first = true;
+                    for (const auto& element : member) {
+                        if (!first) {
+                            out.push_back(',');
+                            write_newline(out);
+                        }
+                        first = false;
+
+                        write_indent(out);
+                        serialize_member(out, element);
                     }
-                    first = false;
 
-                    write_indent(oss);
-                    serialize_string(oss, key);
-                    oss << ':';
-                    write_space(oss);
-                    serialize_value(oss, val);
+                    --current_indent_;
+                    write_newline(out);
+                    write_indent(out);
                 }
 
-                --current_indent_;
-                write_newline(oss);
-                write_indent(oss);
+                out.push_back(']');
+            } else {
+                static_assert(sizeof(Member) == 0, "Member type cannot be serialized");
             }
-
-            oss << '}';
         }
     };
 
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <bit>
+
+#if defined(__AVX2__)
+#define JSONPP_SIMD_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSONPP_SIMD_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define JSONPP_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(__PCLMUL__)
+#include <wmmintrin.h>
+#endif
+
+namespace jsonpp::detail {
+
+// 64 input bytes classified into one bit per byte. The instruction set is
+// chosen at compile time; the scalar version is used when none is enabled.
+class simd_block {
+public:
+    static constexpr size_t size = 64;
+
+    [[nodiscard]] static auto load(const char* data) noexcept -> simd_block {
+        simd_block block;
+#if defined(JSONPP_SIMD_AVX2)
+        block.lo_ = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+        block.hi_ = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 32));
+#elif defined(JSONPP_SIMD_SSE2)
+        for (int i = 0; i < 4; ++i) {
+            block.chunks_[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i));
+        }
+#elif defined(JSONPP_SIMD_NEON)
+        for (int i = 0; i < 4; ++i) {
+            block.chunks_[i] = vld1q_u8(reinterpret_cast<const uint8_t*>(data + 16 * i));
+        }
+#else
+        std::memcpy(block.bytes_, data, size);
+#endif
+        return block;
+    }
+
+    // Loads fewer than 64 bytes, filling the rest of the block with `fill`.
+    [[nodiscard]] static auto load_partial(const char* data, size_t count, char fill) noexcept -> simd_block {
+        char buffer[size];
+        std::memset(buffer, fill, size);
+        std::memcpy(buffer, data, count);
+        return load(buffer);
+    }
+
+    [[nodiscard]] auto eq(char ch) const noexcept -> uint64_t {
+#if defined(JSONPP_SIMD_AVX2)
+        const __m256i needle = _mm256_set1_epi8(ch);
+        return combine(_mm256_cmpeq_epi8(lo_, needle), _mm256_cmpeq_epi8(hi_, needle));
+#elif defined(JSONPP_SIMD_SSE2)
+        const __m128i needle = _mm_set1_epi8(ch);
+        __m128i m[4];
+        for (int i = 0; i < 4; ++i) {
+            m[i] = _mm_cmpeq_epi8(chunks_[i], needle);
+        }
+        return combine(m);
+#elif defined(JSONPP_SIMD_NEON)
+        const uint8x16_t needle = vdupq_n_u8(static_cast<uint8_t>(ch));
+        uint8x16_t m[4];
+        for (int i = 0; i < 4; ++i) {
+            m[i] = vceqq_u8(chunks_[i], needle);
+        }
+        return combine(m);
+#else
+        uint64_t mask = 0;
+        for (size_t i = 0; i < size; ++i) {
+            mask |= static_cast<uint64_t>(bytes_[i] == ch) << i;
+        }
+        return mask;
+#endif
+    }
+
+    // Bytes whose unsigned value is <= limit.
+    [[nodiscard]] auto le(unsigned char limit) const noexcept -> uint64_t {
+#if defined(JSONPP_SIMD_AVX2)
+        const __m256i bound = _mm256_set1_epi8(static_cast<char>(limit));
+        return combine(
+            _mm256_cmpeq_epi8(_mm256_min_epu8(lo_, bound), lo_),
+            _mm256_cmpeq_epi8(_mm256_min_epu8(hi_, bound), hi_)
+        );
+#elif defined(JSONPP_SIMD_SSE2)
+        const __m128i bound = _mm_set1_epi8(static_cast<char>(limit));
+        __m128i m[4];
+        for (int i = 0; i < 4; ++i) {
+            m[i] = _mm_cmpeq_epi8(_mm_min_epu8(chunks_[i], bound), chunks_[i]);
+        }
+        return combine(m);
+#elif defined(JSONPP_SIMD_NEON)
+        const uint8x16_t bound = vdupq_n_u8(limit);
+        uint8x16_t m[4];
+        for (int i = 0; i < 4; ++i) {
+            m[i] = vcleq_u8(chunks_[i], bound);
+        }
+        return combine(m);
+#else
+        uint64_t mask = 0;
+        for (size_t i = 0; i < size; ++i) {
+            mask |= static_cast<uint64_t>(static_cast<unsigned char>(bytes_[i]) <= limit) << i;
+        }
+        return mask;
+#endif
+    }
+
+private:
+#if defined(JSONPP_SIMD_AVX2)
+    __m256i lo_;
+    __m256i hi_;
+
+    [[nodiscard]] static auto combine(__m256i lo, __m256i hi) noexcept -> uint64_t {
+        return static_cast<uint32_t>(_mm256_movemask_epi8(lo)) |
+               (static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(hi))) << 32);
+    }
+#elif defined(JSONPP_SIMD_SSE2)
+    __m128i chunks_[4];
+
+    [[nodiscard]] static auto combine(const __m128i* m) noexcept -> uint64_t {
+        uint64_t mask = 0;
+        for (int i = 0; i < 4; ++i) {
+            mask |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(m[i]))) << (16 * i);
+        }
+        return mask;
+    }
+#elif defined(JSONPP_SIMD_NEON)
+    uint8x16_t chunks_[4];
+
+    [[nodiscard]] static auto combine(const uint8x16_t* m) noexcept -> uint64_t {
+        static constexpr uint8_t weight_bytes[16] = {
+            0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+            0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80
+        };
+        const uint8x16_t weights = vld1q_u8(weight_bytes);
+        uint8x16_t sum0 = vpaddq_u8(vandq_u8(m[0], weights), vandq_u8(m[1], weights));
+        uint8x16_t sum1 = vpaddq_u8(vandq_u8(m[2], weights), vandq_u8(m[3], weights));
+        sum0 = vpaddq_u8(sum0, sum1);
+        sum0 = vpaddq_u8(sum0, sum0);
+        return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+    }
+#else
+    char bytes_[size];
+#endif
+};
+
+// Bit i of the result is the xor of bits 0..i of the input.
+[[nodiscard]] inline auto prefix_xor(uint64_t bits) noexcept -> uint64_t {
+#if defined(__PCLMUL__)
+    const __m128i product = _mm_clmulepi64_si128(
+        _mm_set_epi64x(0, static_cast<long long>(bits)), _mm_set1_epi8(static_cast<char>(0xFF)), 0);
+    return static_cast<uint64_t>(_mm_cvtsi128_si64(product));
+#else
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+#endif
+}
+
+// Length of the leading run of bytes that need no special handling inside a
+// JSON string, i.e. the offset of the first '"', '\\' or control character.
+[[nodiscard]] inline auto plain_string_run(const char* data, size_t count) noexcept -> size_t {
+    size_t offset = 0;
+    for (; offset + simd_block::size <= count; offset += simd_block::size) {
+        const auto block = simd_block::load(data + offset);
+        const uint64_t special = block.eq('"') | block.eq('\\') | block.le(0x1F);
+        if (special != 0) {
+            return offset + static_cast<size_t>(std::countr_zero(special));
+        }
+    }
+    for (; offset < count; ++offset) {
+        const auto ch = static_cast<unsigned char>(data[offset]);
+        if (ch == '"' || ch == '\\' || ch < 0x20) {
+            break;
+        }
+    }
+    return offset;
+}
+
+// Length of the well-formed UTF-8 sequence starting with a non-ASCII byte
+// at data, or 0 when it is malformed, overlong, a surrogate or beyond
+// U+10FFFF (RFC 3629).
+[[nodiscard]] inline auto utf8_sequence_length(const unsigned char* data, size_t count) noexcept -> size_t {
+    const unsigned lead = data[0];
+    size_t length;
+    unsigned low = 0x80;
+    unsigned high = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        low = lead == 0xE0 ? 0xA0 : 0x80;
+        high = lead == 0xED ? 0x9F : 0xBF;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        low = lead == 0xF0 ? 0x90 : 0x80;
+        high = lead == 0xF4 ? 0x8F : 0xBF;
+    } else {
+        return 0;
+    }
+    if (count < length || data[1] < low || data[1] > high) {
+        return 0;
+    }
+    for (size_t i = 2; i < length; ++i) {
+        if ((data[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+// Offset of the first byte that is not part of well-formed UTF-8, or count
+// when all of it is. Runs of ASCII, the common case even in non-English
+// text, are stepped over 64 bytes at a time.
+[[nodiscard]] inline auto find_invalid_utf8(const char* data, size_t count) noexcept -> size_t {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+    size_t offset = 0;
+    while (offset < count) {
+        if (offset + simd_block::size <= count) {
+            const uint64_t non_ascii = ~simd_block::load(data + offset).le(0x7F);
+            if (non_ascii == 0) {
+                offset += simd_block::size;
+                continue;
+            }
+            offset += static_cast<size_t>(std::countr_zero(non_ascii));
+        } else {
+            while (offset < count && bytes[offset] < 0x80) {
+                ++offset;
+            }
+            if (offset == count) {
+                break;
+            }
+        }
+        const size_t length = utf8_sequence_length(bytes + offset, count - offset);
+        if (length == 0) {
+            return offset;
+        }
+        offset += length;
+    }
+    return count;
+}
+
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <concepts>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include "json_exception.hpp"
+
+#if defined(_WIN32)
+    #include <io.h>
+#else
+    #include <sys/uio.h>
+    #include <unistd.h>
+#endif
+
+namespace jsonpp {
+
+// Destination for buffered output. write() receives the pending output as a
+// few contiguous pieces, in order, and must consume all of them or throw.
+template <typename Sink>
+concept output_sink = requires(Sink& sink, std::span<const std::string_view> pieces) {
+    sink.write(pieces);
+};
+
+namespace detail {
+
+    [[noreturn]] inline auto fail_write(const char* target, int error) -> void {
+        throw json_exception{
+            std::format("Cannot write to {}: {}", target, std::system_category().message(error))
+        };
+    }
+
+}
+
+// Writes to a C stdio stream; the stream's own buffering still applies.
+class file_sink {
+public:
+    explicit file_sink(std::FILE* file) noexcept
+        : file_{ file } {}
+
+    auto write(std::span<const std::string_view> pieces) -> void {
+        for (const auto piece : pieces) {
+            if (std::fwrite(piece.data(), 1, piece.size(), file_) != piece.size()) {
+                detail::fail_write("file", errno);
+            }
+        }
+    }
+
+private:
+    std::FILE* file_;
+};
+
+// Writes to a file descriptor or socket. On POSIX all pieces go out in one
+// writev() call, retried after partial writes and EINTR.
+class fd_sink {
+public:
+    explicit fd_sink(int fd) noexcept
+        : fd_{ fd } {}
+
+    auto write(std::span<const std::string_view> pieces) -> void {
+#if defined(_WIN32)
+        for (auto piece : pieces) {
+            while (!piece.empty()) {
+                const auto chunk = static_cast<unsigned>(std::min<size_t>(piece.size(), INT_MAX));
+                const int written = ::_write(fd_, piece.data(), chunk);
+                if (written < 0) {
+                    detail::fail_write("descriptor", errno);
+                }
+                piece.remove_prefix(static_cast<size_t>(written));
+            }
+        }
+#else
+        constexpr size_t max_pieces = 16;
+        ::iovec vectors[max_pieces];
+        while (!pieces.empty()) {
+            size_t count = 0;
+            for (; count < std::min(pieces.size(), max_pieces); ++count) {
+                vectors[count] = { const_cast<char*>(pieces[count].data()), pieces[count].size() };
+            }
+            ::iovec* pending = vectors;
+            while (count != 0) {
+                const ssize_t written = ::writev(fd_, pending, static_cast<int>(count));
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    detail::fail_write("descriptor", errno);
+                }
+                auto remaining = static_cast<size_t>(written);
+                while (count != 0 && remaining >= pending->iov_len) {
+                    remaining -= pending->iov_len;
+                    ++pending;
+                    --count;
+                }
+                if (count != 0) {
+                    pending->iov_base = static_cast<char*>(pending->iov_base) + remaining;
+                    pending->iov_len -= remaining;
+                }
+            }
+            pieces = pieces.subspan(std::min(pieces.size(), max_pieces));
+        }
+#endif
+    }
+
+private:
+    int fd_;
+};
+
+// Hands every piece to a callable taking std::string_view.
+template <std::invocable<std::string_view> Callback>
+class callback_sink {
+public:
+    explicit callback_sink(Callback callback)
+        : callback_{ std::move(callback) } {}
+
+    auto write(std::span<const std::string_view> pieces) -> void {
+        for (const auto piece : pieces) {
+            std::invoke(callback_, piece);
+        }
+    }
+
+private:
+    Callback callback_;
+};
+
+// Fixed-size output buffer that flushes into a sink whenever it fills, so
+// output of any size needs no more memory than the buffer. It satisfies
+// output_buffer and can be given to serializer::serialize_to() or a writer.
+// Pieces larger than the buffer bypass it and go to the sink directly.
+//
+// Call flush() to see write errors; the destructor flushes too but has to
+// swallow them.
+template <output_sink Sink>
+class sink_buffer {
+public:
+    // Stands in for an iterator in the insert() calls of output_buffer;
+    // output can only ever be appended.
+    struct end_position {};
+
+    static constexpr size_t default_capacity = size_t{ 64 } << 10;
+
+    explicit sink_buffer(Sink& sink, size_t capacity = default_capacity)
+        : sink_{ sink },
+          capacity_{ std::max<size_t>(capacity, 64) },
+          data_{ std::make_unique_for_overwrite<char[]>(capacity_) } {}
+
+    sink_buffer(const sink_buffer&) = delete;
+    auto operator=(const sink_buffer&) -> sink_buffer& = delete;
+
+    ~sink_buffer() {
+        try {
+            flush();
+        } catch (...) {
+        }
+    }
+
+    auto push_back(char ch) -> void {
+        if (size_ == capacity_) {
+            flush();
+        }
+        data_[size_++] = ch;
+    }
+
+    auto append(const char* text, size_t count) -> void {
+        if (count <= capacity_ - size_) {
+            std::memcpy(data_.get() + size_, text, count);
+            size_ += count;
+            return;
+        }
+        if (count >= capacity_) {
+            const std::string_view pieces[] = { { data_.get(), size_ }, { text, count } };
+            sink_.write(pieces);
+            written_ += size_ + count;
+            size_ = 0;
+            return;
+        }
+        flush();
+        std::memcpy(data_.get(), text, count);
+        size_ = count;
+    }
+
+    [[nodiscard]] auto end() const noexcept -> end_position {
+        return {};
+    }
+
+    auto insert(end_position, const char* first, const char* last) -> void {
+        append(first, static_cast<size_t>(last - first));
+    }
+
+    auto insert(end_position, size_t count, char ch) -> void {
+        while (count != 0) {
+            if (size_ == capacity_) {
+                flush();
+            }
+            const size_t chunk = std::min(count, capacity_ - size_);
+            std::memset(data_.get() + size_, ch, chunk);
+            size_ += chunk;
+            count -= chunk;
+        }
+    }
+
+    auto flush() -> void {
+        if (size_ == 0) {
+            return;
+        }
+        const std::string_view pieces[] = { { data_.get(), size_ } };
+        const size_t pending = std::exchange(size_, 0);
+        sink_.write(pieces);
+        written_ += pending;
+    }
+
+    // Bytes handed to the sink so far, not counting what is still buffered.
+    [[nodiscard]] auto bytes_written() const noexcept -> size_t {
+        return written_;
+    }
+
+private:
+    Sink& sink_;
+    size_t capacity_;
+    std::unique_ptr<char[]> data_;
+    size_t size_ = 0;
+    size_t written_ = 0;
+};
+
+}
@@ -0,0 +1,410 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <bit>
+#include <cstdint>
+#include <algorithm>
+#include <format>
+#include "json_value.hpp"
+#include "json_parser.hpp"
+#include "json_scanner.hpp"
+#include "json_simd.hpp"
+#include "json_tape.hpp"
+#include "json_parallel.hpp"
+#include "json_exception.hpp"
+
+namespace jsonpp {
+
+struct parallel_options {
+    parse_options parse{};
+
+    // Inputs are cut into pieces of at least this many bytes; anything
+    // shorter than two pieces is parsed on the calling thread.
+    size_t min_chunk_size = size_t{ 1 } << 20;
+
+    // Pieces handed out per thread, so threads that finish early keep
+    // taking work.
+    size_t chunks_per_thread = 4;
+
+    // Defaults to thread_pool::shared().
+    thread_pool* pool = nullptr;
+};
+
+namespace detail {
+
+    // Finds the commas between the members of a top-level array or object
+    // so they can be parsed independently. Two parallel passes run over
+    // fixed chunks: the first counts unescaped quotes to learn where each
+    // chunk starts relative to strings, the second tracks bracket depth and
+    // notes the first comma at every depth below the chunk's start. A prefix
+    // sum of the depths then tells which of those commas is at top level.
+    class split_finder {
+    public:
+        split_finder(std::string_view input, size_t chunk_size, thread_pool& pool)
+            : input_{ input }, chunk_size_{ chunk_size / simd_block::size * simd_block::size }, pool_{ pool } {}
+
+        // Offsets of top-level commas, at most one per chunk, ascending.
+        [[nodiscard]] auto find() -> std::vector<size_t> {
+            const size_t count = (input_.size() + chunk_size_ - 1) / chunk_size_;
+            chunks_.assign(count, {});
+
+            pool_.for_each_index(count, [&](size_t i) { count_quotes(i); });
+            uint64_t in_string = 0;
+            for (auto& c : chunks_) {
+                c.starts_in_string = in_string;
+                in_string ^= c.quote_parity;
+            }
+
+            pool_.for_each_index(count, [&](size_t i) { track_depth(i); });
+            std::vector<size_t> splits;
+            int64_t depth = 0;
+            for (const auto& c : chunks_) {
+                // Members of the root container sit at depth 1.
+                const auto below = static_cast<size_t>(depth - 1);
+                if (depth >= 1 && below < c.first_comma.size() && c.first_comma[below] != no_comma) {
+                    splits.push_back(c.first_comma[below]);
+                }
+                depth += c.depth_delta;
+            }
+            return splits;
+        }
+
+    private:
+        static constexpr size_t no_comma = static_cast<size_t>(-1);
+
+        struct chunk {
+            uint64_t quote_parity = 0;
+            uint64_t starts_in_string = 0;
+            int64_t depth_delta = 0;
+            // first_comma[d]: the first comma reached d levels below the
+            // depth at which the chunk starts.
+            std::vector<size_t> first_comma;
+        };
+
+        std::string_view input_;
+        size_t chunk_size_;
+        thread_pool& pool_;
+        std::vector<chunk> chunks_;
+
+        // A chunk starts escaped when an odd run of backslashes precedes it.
+        [[nodiscard]] auto escape_carry(size_t begin) const noexcept -> uint64_t {
+            size_t run = 0;
+            while (run < begin && input_[begin - run - 1] == '\\') {
+                ++run;
+            }
+            return run & 1;
+        }
+
+        template <typename Visit>
+        auto for_each_block(size_t index, Visit&& visit) const -> void {
+            const size_t begin = index * chunk_size_;
+            const size_t end = std::min(begin + chunk_size_, input_.size());
+            for (size_t offset = begin; offset < end; offset += simd_block::size) {
+                const size_t length = std::min(simd_block::size, end - offset);
+                const auto block = length == simd_block::size
+                    ? simd_block::load(input_.data() + offset)
+                    : simd_block::load_partial(input_.data() + offset, length, ' ');
+                visit(block, offset);
+            }
+        }
+
+        auto count_quotes(size_t index) -> void {
+            uint64_t carry = escape_carry(index * chunk_size_);
+            uint64_t parity = 0;
+            for_each_block(index, [&](const simd_block& block, size_t) {
+                const uint64_t escaped = find_escaped(block.eq('\\'), carry);
+                parity ^= static_cast<uint64_t>(std::popcount(block.eq('"') & ~escaped) & 1);
+            });
+            chunks_[index].quote_parity = parity;
+        }
+
+        auto track_depth(size_t index) -> void {
+            chunk& c = chunks_[index];
+            uint64_t carry = escape_carry(index * chunk_size_);
+            uint64_t in_string_carry = c.starts_in_string != 0 ? ~uint64_t{ 0 } : 0;
+            int64_t depth = 0;
+            for_each_block(index, [&](const simd_block& block, size_t offset) {
+                const uint64_t escaped = find_escaped(block.eq('\\'), carry);
+                const uint64_t quotes = block.eq('"') & ~escaped;
+                const uint64_t in_string = prefix_xor(quotes) ^ in_string_carry;
+                in_string_carry = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+
+                const uint64_t opens = (block.eq('{') | block.eq('[')) & ~in_string;
+                const uint64_t closes = (block.eq('}') | block.eq(']')) & ~in_string;
+                const uint64_t commas = block.eq(',') & ~in_string;
+                for (uint64_t bits = opens | closes | commas; bits != 0; bits &= bits - 1) {
+                    const uint64_t bit = bits & (~bits + 1);
+                    if (opens & bit) {
+                        ++depth;
+                    } else if (closes & bit) {
+                        --depth;
+                    } else if (depth <= 0) {
+                        const auto below = static_cast<size_t>(-depth);
+                        if (below >= c.first_comma.size()) {
+                            c.first_comma.resize(below + 1, no_comma);
+                        }
+                        if (c.first_comma[below] == no_comma) {
+                            c.first_comma[below] = offset + static_cast<size_t>(std::countr_zero(bit));
+                        }
+                    }
+                }
+            });
+            c.depth_delta = depth;
+        }
+    };
+
+    // Where the members of the root container lie: between open and close,
+    // cut at the given commas.
+    struct split_layout {
+        size_t open = 0;
+        size_t close = 0;
+        bool object = false;
+        std::vector<size_t> splits;
+
+        [[nodiscard]] auto segments() const noexcept -> size_t {
+            return splits.size() + 1;
+        }
+
+        [[nodiscard]] auto segment_begin(size_t i) const noexcept -> size_t {
+            return i == 0 ? open + 1 : splits[i - 1] + 1;
+        }
+
+        [[nodiscard]] auto segment_end(size_t i) const noexcept -> size_t {
+            return i == splits.size() ? close : splits[i];
+        }
+    };
+
+    // Returns false when the input is too small to split or is not a
+    // non-empty array or object; the caller then parses it serially, which
+    // also reports any error at the right place.
+    [[nodiscard]] inline auto plan_split(std::string_view input, const parallel_options& options, thread_pool& pool,
+                                         split_layout& layout) -> bool {
+        const size_t chunk_size = std::max(options.min_chunk_size, input.size() / std::max<size_t>(pool.size() * options.chunks_per_thread, 1));
+        if (pool.size() < 2 || input.size() < 2 * chunk_size || chunk_size < simd_block::size) {
+            return false;
+        }
+
+        layout.open = 0;
+        while (layout.open < input.size() && is_whitespace(input[layout.open])) {
+            ++layout.open;
+        }
+        layout.close = input.size();
+        while (layout.close > layout.open && is_whitespace(input[layout.close - 1])) {
+            --layout.close;
+        }
+        if (layout.close - layout.open < 2) {
+            return false;
+        }
+        --layout.close;
+
+        const char first = input[layout.open];
+        const char last = input[layout.close];
+        if (!((first == '[' && last == ']') || (first == '{' && last == '}'))) {
+            return false;
+        }
+        layout.object = first == '{';
+
+        split_finder finder{ input, chunk_size, pool };
+        layout.splits = finder.find();
+        std::erase_if(layout.splits, [&](size_t split) { return split <= layout.open || split >= layout.close; });
+        return !layout.splits.empty();
+    }
+
+    // Parses the members between begin and end, which is a split comma or
+    // the root's closing bracket, and returns how many there were.
+    template <sax_handler Handler>
+    auto parse_segment(
+        std::string_view input,
+        const split_layout& layout,
+        size_t segment,
+        Handler& handler,
+        const parse_options& options
+    ) -> size_t {
+        parse_options segment_options = options;
+        segment_options.structural_index = false;
+        // Members sit one level below the root.
+        if (segment_options.max_depth > 0) {
+            --segment_options.max_depth;
+        }
+        basic_parser<Handler> reader{ input, handler, segment_options };
+
+        const size_t end = layout.segment_end(segment);
+        const char close = layout.object ? '}' : ']';
+        reader.start_at(layout.segment_begin(segment));
+
+        size_t count = 0;
+        while (true) {
+            if (layout.object) {
+                if (reader.peek_token() != '"') {
+                    throw parse_exception{"Expected string key in object", reader.position()};
+                }
+                handler.on_key(reader.read_string());
+                reader.expect_token(':');
+            }
+            reader.read_value();
+            ++count;
+
+            const char ch = reader.peek_token();
+            if (reader.position() == end) {
+                return count;
+            }
+            if (ch != ',' || reader.position() > end) {
+                throw parse_exception{
+                    std::format("Expected ',' or '{}', got '{}'", close, ch),
+                    reader.position()
+                };
+            }
+            reader.expect_token(',');
+            if (reader.peek_token() == close && reader.position() == layout.close) {
+                throw parse_exception{
+                    layout.object ? "Trailing comma in object" : "Trailing comma in array",
+                    reader.position()
+                };
+            }
+        }
+    }
+
+    // Moves one segment's tape into the combined tape at word base and
+    // string offset string_base, shifting every stored position.
+    inline auto relocate_tape(std::span<const uint64_t> words, uint64_t* out, uint64_t base, uint64_t string_base) noexcept
+        -> void {
+        for (size_t i = 0; i < words.size(); ++i) {
+            const uint64_t word = words[i];
+            switch (tape::tag_of(word)) {
+                case tape_tag::integer:
+                case tape_tag::number:
+                    out[i] = word;
+                    out[i + 1] = words[i + 1];
+                    ++i;
+                    break;
+                case tape_tag::string:
+                    out[i] = word + string_base;
+                    break;
+                case tape_tag::start_array:
+                case tape_tag::start_object:
+                case tape_tag::end_array:
+                case tape_tag::end_object:
+                    out[i] = word + base;
+                    break;
+                default:
+                    out[i] = word;
+                    break;
+            }
+        }
+    }
+
+}
+
+// Parses a large array or object in parallel: the members of the root are
+// split at top-level commas, parsed on the thread pool and stitched back
+// together in order. The result is the same as parse(), and inputs that
+// cannot be split are parsed serially. Strings are allocated from the
+// default resource, which unlike a document arena is safe to share between
+// threads.
+[[nodiscard]] inline auto parse_parallel(std::string_view json_text, const parallel_options& options = {}) -> value {
+    auto& pool = options.pool != nullptr ? *options.pool : thread_pool::shared();
+
+    detail::split_layout layout;
+    if (!detail::plan_split(json_text, options, pool, layout)) {
+        parser p{ json_text, options.parse };
+        return p.parse();
+    }
+
+    std::vector<value> segments(layout.segments());
+    pool.for_each_index(segments.size(), [&](size_t i) {
+        dom_builder builder{ json_text, std::pmr::get_default_resource(), options.parse.borrow_strings, options.parse.keys };
+        const size_t count = detail::parse_segment(json_text, layout, i, builder, options.parse);
+        if (layout.object) {
+            builder.end_object(count);
+        } else {
+            builder.end_array(count);
+        }
+        segments[i] = builder.release();
+    });
+
+    size_t total = 0;
+    for (const auto& segment : segments) {
+        total += segment.size();
+    }
+
+    if (layout.object) {
+        object_type result;
+        result.reserve(total);
+        for (auto& segment : segments) {
+            result.merge(std::move(segment.as_object()));
+        }
+        return value(std::move(result));
+    }
+
+    array_type result;
+    result.reserve(total);
+    for (auto& segment : segments) {
+        for (auto& element : segment.as_array()) {
+            result.push_back(std::move(element));
+        }
+    }
+    return value(std::move(result));
+}
+
+// The tape counterpart of parse_parallel(). Each piece is parsed onto its own
+// tape; the pieces are then copied into place in parallel with their
+// positions shifted.
+[[nodiscard]] inline auto parse_tape_parallel(std::string_view json_text, const parallel_options& options = {})
+    -> tape_document {
+    auto& pool = options.pool != nullptr ? *options.pool : thread_pool::shared();
+
+    detail::split_layout layout;
+    if (!detail::plan_split(json_text, options, pool, layout)) {
+        return tape_document{ json_text, options.parse };
+    }
+
+    struct piece {
+        std::vector<uint64_t> words;
+        std::string strings;
+        size_t count = 0;
+        size_t word_base = 0;
+        size_t string_base = 0;
+    };
+
+    std::vector<piece> pieces(layout.segments());
+    pool.for_each_index(pieces.size(), [&](size_t i) {
+        auto& p = pieces[i];
+        p.words.reserve((layout.segment_end(i) - layout.segment_begin(i)) / 8 + 16);
+        tape_builder builder{ p.words, p.strings };
+        p.count = detail::parse_segment(json_text, layout, i, builder, options.parse);
+    });
+
+    size_t words = 1;
+    size_t strings = 0;
+    size_t count = 0;
+    for (auto& p : pieces) {
+        p.word_base = words;
+        p.string_base = strings;
+        words += p.words.size();
+        strings += p.strings.size();
+        count += p.count;
+    }
+    if (words + 1 > UINT32_MAX) {
+        throw json_exception{"Document too large for a tape"};
+    }
+
+    std::vector<uint64_t> tape(words + 1);
+    std::string buffer(strings, '\0');
+    pool.for_each_index(pieces.size(), [&](size_t i) {
+        auto& p = pieces[i];
+        detail::relocate_tape(p.words, tape.data() + p.word_base, p.word_base, p.string_base);
+        std::copy(p.strings.begin(), p.strings.end(), buffer.begin() + static_cast<std::ptrdiff_t>(p.string_base));
+        p = {};
+    });
+
+    const auto open_tag = layout.object ? tape_tag::start_object : tape_tag::start_array;
+    const auto close_tag = layout.object ? tape_tag::end_object : tape_tag::end_array;
+    const uint64_t saturated = std::min<uint64_t>(count, tape::count_saturated);
+    tape.front() = tape::word(open_tag, saturated << 32 | tape.size());
+    tape.back() = tape::word(close_tag, 0);
+    return tape_document{ std::move(tape), std::move(buffer) };
+}
+
+}
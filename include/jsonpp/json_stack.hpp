@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstddef>
+
+namespace jsonpp::detail {
+
+// The explicit stack that stands in for recursion in the parser and the
+// serializer. The first Inline entries live in the object itself, so
+// documents nested less deeply than that never allocate for it; deeper
+// levels spill into a vector that keeps its capacity when popped.
+template <typename T, size_t Inline>
+class inline_stack {
+public:
+    [[nodiscard]] auto size() const noexcept -> size_t {
+        return size_;
+    }
+
+    [[nodiscard]] auto empty() const noexcept -> bool {
+        return size_ == 0;
+    }
+
+    [[nodiscard]] auto back() noexcept -> T& {
+        return size_ <= Inline ? inline_[size_ - 1] : overflow_[size_ - 1 - Inline];
+    }
+
+    auto push(const T& entry) -> void {
+        if (size_ < Inline) {
+            inline_[size_] = entry;
+        } else if (size_ - Inline < overflow_.size()) {
+            overflow_[size_ - Inline] = entry;
+        } else {
+            overflow_.push_back(entry);
+        }
+        ++size_;
+    }
+
+    auto pop() noexcept -> void {
+        --size_;
+    }
+
+    // Drops entries above count, such as those left by a failed parse.
+    auto truncate(size_t count) noexcept -> void {
+        if (count < size_) {
+            size_ = count;
+        }
+    }
+
+    [[nodiscard]] auto capacity_bytes() const noexcept -> size_t {
+        return overflow_.capacity() * sizeof(T);
+    }
+
+    // Only while no more than Inline entries are held.
+    auto shrink() noexcept -> void {
+        std::vector<T>{}.swap(overflow_);
+    }
+
+private:
+    std::array<T, Inline> inline_{};
+    std::vector<T> overflow_;
+    size_t size_ = 0;
+};
+
+}
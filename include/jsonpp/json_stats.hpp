@@ -0,0 +1,368 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// Define JSONPP_ENABLE_STATS before including jsonpp to collect parse and
+// serialize statistics. Without it every hook compiles to nothing, and
+// stats() returns zeros.
+#if defined(JSONPP_ENABLE_STATS)
+    #define JSONPP_DETAIL_STATS 1
+#else
+    #define JSONPP_DETAIL_STATS 0
+#endif
+
+namespace jsonpp {
+
+inline constexpr bool stats_enabled = JSONPP_DETAIL_STATS != 0;
+
+// Counters for one or more parsed documents. Times are in nanoseconds and
+// nest: total_ns covers the whole parse, including the phases. String time
+// covers reading every string and key, number time converting every
+// number, and build time closing containers in the handler; these three
+// are estimated from a sample of the tokens.
+struct parse_stats {
+    uint64_t documents = 0;
+    uint64_t bytes_scanned = 0;
+    uint64_t nulls = 0;
+    uint64_t booleans = 0;
+    uint64_t integers = 0;
+    uint64_t doubles = 0;
+    uint64_t strings = 0;
+    uint64_t keys = 0;
+    uint64_t escaped_strings = 0;
+    uint64_t arrays = 0;
+    uint64_t objects = 0;
+    uint64_t max_depth = 0;
+    uint64_t allocations = 0;
+    uint64_t allocated_bytes = 0;
+    uint64_t scan_ns = 0;
+    uint64_t string_ns = 0;
+    uint64_t number_ns = 0;
+    uint64_t build_ns = 0;
+    uint64_t total_ns = 0;
+
+    auto operator+=(const parse_stats& other) noexcept -> parse_stats&;
+};
+
+struct serialize_stats {
+    uint64_t documents = 0;
+    uint64_t values = 0;
+    // Only counted for buffers with a size(), such as std::string.
+    uint64_t bytes_written = 0;
+    uint64_t total_ns = 0;
+
+    auto operator+=(const serialize_stats& other) noexcept -> serialize_stats&;
+};
+
+namespace detail {
+
+    // Every summed counter, with the metric it is exported as. max_depth
+    // is the one counter merged by maximum rather than summed.
+    struct stat_field {
+        const char* metric;
+        const char* label;
+        uint64_t parse_stats::* field;
+    };
+
+    inline constexpr std::array<stat_field, 18> summed_parse_fields{ {
+        { "parse_documents_total", "", &parse_stats::documents },
+        { "parse_bytes_total", "", &parse_stats::bytes_scanned },
+        { "parse_values_total", "type=\"null\"", &parse_stats::nulls },
+        { "parse_values_total", "type=\"boolean\"", &parse_stats::booleans },
+        { "parse_values_total", "type=\"integer\"", &parse_stats::integers },
+        { "parse_values_total", "type=\"double\"", &parse_stats::doubles },
+        { "parse_values_total", "type=\"string\"", &parse_stats::strings },
+        { "parse_values_total", "type=\"array\"", &parse_stats::arrays },
+        { "parse_values_total", "type=\"object\"", &parse_stats::objects },
+        { "parse_keys_total", "", &parse_stats::keys },
+        { "parse_escaped_strings_total", "", &parse_stats::escaped_strings },
+        { "parse_allocations_total", "", &parse_stats::allocations },
+        { "parse_allocated_bytes_total", "", &parse_stats::allocated_bytes },
+        { "parse_seconds_total", "phase=\"scan\"", &parse_stats::scan_ns },
+        { "parse_seconds_total", "phase=\"string\"", &parse_stats::string_ns },
+        { "parse_seconds_total", "phase=\"number\"", &parse_stats::number_ns },
+        { "parse_seconds_total", "phase=\"build\"", &parse_stats::build_ns },
+        { "parse_seconds_total", "phase=\"total\"", &parse_stats::total_ns },
+    } };
+
+    [[nodiscard]] inline auto now_ns() noexcept -> uint64_t {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Adds the time until it goes out of scope, times scale, to a counter;
+    // a timer without a counter does nothing and reads no clock.
+    class stat_timer {
+    public:
+        stat_timer(uint64_t* total, uint64_t scale) noexcept
+            : total_{ total }, scale_{ scale }, start_{ total != nullptr ? now_ns() : 0 } {}
+
+        stat_timer(const stat_timer&) = delete;
+        auto operator=(const stat_timer&) -> stat_timer& = delete;
+
+        ~stat_timer() {
+            if (total_ != nullptr) {
+                *total_ += (now_ns() - start_) * scale_;
+            }
+        }
+
+    private:
+        uint64_t* total_;
+        uint64_t scale_;
+        uint64_t start_;
+    };
+
+    struct no_timer {};
+
+}
+
+inline auto parse_stats::operator+=(const parse_stats& other) noexcept -> parse_stats& {
+    for (const auto& entry : detail::summed_parse_fields) {
+        this->*entry.field += other.*entry.field;
+    }
+    max_depth = std::max(max_depth, other.max_depth);
+    return *this;
+}
+
+inline auto serialize_stats::operator+=(const serialize_stats& other) noexcept -> serialize_stats& {
+    documents += other.documents;
+    values += other.values;
+    bytes_written += other.bytes_written;
+    total_ns += other.total_ns;
+    return *this;
+}
+
+// Process-wide totals that every parser and serializer adds its documents
+// to when statistics are enabled. Updates are lock-free.
+class stats_aggregator {
+public:
+    auto add(const parse_stats& stats) noexcept -> void {
+        for (size_t i = 0; i < detail::summed_parse_fields.size(); ++i) {
+            parse_[i].fetch_add(stats.*detail::summed_parse_fields[i].field, std::memory_order_relaxed);
+        }
+        uint64_t depth = max_depth_.load(std::memory_order_relaxed);
+        while (depth < stats.max_depth &&
+               !max_depth_.compare_exchange_weak(depth, stats.max_depth, std::memory_order_relaxed)) {
+        }
+    }
+
+    auto add(const serialize_stats& stats) noexcept -> void {
+        serialize_[0].fetch_add(stats.documents, std::memory_order_relaxed);
+        serialize_[1].fetch_add(stats.values, std::memory_order_relaxed);
+        serialize_[2].fetch_add(stats.bytes_written, std::memory_order_relaxed);
+        serialize_[3].fetch_add(stats.total_ns, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] auto parsing() const noexcept -> parse_stats {
+        parse_stats result;
+        for (size_t i = 0; i < detail::summed_parse_fields.size(); ++i) {
+            result.*detail::summed_parse_fields[i].field = parse_[i].load(std::memory_order_relaxed);
+        }
+        result.max_depth = max_depth_.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    [[nodiscard]] auto serializing() const noexcept -> serialize_stats {
+        return {
+            serialize_[0].load(std::memory_order_relaxed),
+            serialize_[1].load(std::memory_order_relaxed),
+            serialize_[2].load(std::memory_order_relaxed),
+            serialize_[3].load(std::memory_order_relaxed),
+        };
+    }
+
+    auto reset() noexcept -> void {
+        for (auto& counter : parse_) {
+            counter.store(0, std::memory_order_relaxed);
+        }
+        for (auto& counter : serialize_) {
+            counter.store(0, std::memory_order_relaxed);
+        }
+        max_depth_.store(0, std::memory_order_relaxed);
+    }
+
+    // The totals in the Prometheus text exposition format, with every
+    // metric name starting with prefix followed by an underscore.
+    [[nodiscard]] auto to_prometheus(std::string_view prefix = "jsonpp") const -> std::string {
+        const parse_stats parsed = parsing();
+        const serialize_stats serialized = serializing();
+        std::string out;
+        std::string_view previous;
+        for (const auto& entry : detail::summed_parse_fields) {
+            const std::string_view metric = entry.metric;
+            if (metric != previous) {
+                out += std::format("# TYPE {}_{} counter\n", prefix, metric);
+                previous = metric;
+            }
+            const std::string_view label = entry.label;
+            const std::string labels = label.empty() ? std::string{} : std::format("{{{}}}", label);
+            out += std::format("{}_{}{} ", prefix, metric, labels);
+            append_sample(out, metric, parsed.*entry.field);
+        }
+        out += std::format("# TYPE {}_parse_max_depth gauge\n{}_parse_max_depth {}\n", prefix, prefix, parsed.max_depth);
+        const std::pair<std::string_view, uint64_t> serialize_counters[] = {
+            { "serialize_documents_total", serialized.documents },
+            { "serialize_values_total", serialized.values },
+            { "serialize_bytes_total", serialized.bytes_written },
+            { "serialize_seconds_total", serialized.total_ns },
+        };
+        for (const auto& [metric, count] : serialize_counters) {
+            out += std::format("# TYPE {}_{} counter\n{}_{} ", prefix, metric, prefix, metric);
+            append_sample(out, metric, count);
+        }
+        return out;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, detail::summed_parse_fields.size()> parse_{};
+    std::array<std::atomic<uint64_t>, 4> serialize_{};
+    std::atomic<uint64_t> max_depth_{ 0 };
+
+    // Times are kept in nanoseconds but exported in seconds.
+    static auto append_sample(std::string& out, std::string_view metric, uint64_t count) -> void {
+        if (metric.ends_with("_seconds_total")) {
+            out += std::format("{}\n", static_cast<double>(count) / 1e9);
+        } else {
+            out += std::format("{}\n", count);
+        }
+    }
+};
+
+[[nodiscard]] inline auto global_stats() noexcept -> stats_aggregator& {
+    static stats_aggregator instance;
+    return instance;
+}
+
+namespace detail {
+
+    // What basic_parser records into. Each hook is a no-op, and the object
+    // is empty, when statistics are disabled.
+    class parse_recorder {
+    public:
+#if JSONPP_DETAIL_STATS
+        auto begin() noexcept -> void {
+            stats_ = {};
+            depth_ = 0;
+            start_ = now_ns();
+        }
+
+        // Completes the document and adds it to global_stats().
+        auto finish(size_t bytes) noexcept -> void {
+            stats_.documents = 1;
+            stats_.bytes_scanned = bytes;
+            stats_.total_ns = now_ns() - start_;
+            global_stats().add(stats_);
+        }
+
+        [[nodiscard]] auto time(uint64_t parse_stats::* phase) noexcept -> stat_timer {
+            return stat_timer{ &(stats_.*phase), 1 };
+        }
+
+        // For phases entered once per token: reading the clock that often
+        // would halve parsing speed, so only one call in sample_rate is
+        // timed and scaled up. The count runs across parsers on the thread,
+        // so small documents are sampled too.
+        [[nodiscard]] auto sample(uint64_t parse_stats::* phase) noexcept -> stat_timer {
+            thread_local uint64_t ticks = 0;
+            return stat_timer{ ++ticks % sample_rate == 0 ? &(stats_.*phase) : nullptr, sample_rate };
+        }
+
+        auto count(uint64_t parse_stats::* field) noexcept -> void {
+            ++(stats_.*field);
+        }
+
+        auto enter(uint64_t parse_stats::* field) noexcept -> void {
+            ++(stats_.*field);
+            if (++depth_ > stats_.max_depth) {
+                stats_.max_depth = depth_;
+            }
+        }
+
+        auto leave() noexcept -> void {
+            --depth_;
+        }
+
+        auto allocated(size_t bytes, size_t count = 1) noexcept -> void {
+            stats_.allocations += count;
+            stats_.allocated_bytes += bytes;
+        }
+
+        [[nodiscard]] auto stats() const noexcept -> const parse_stats& {
+            return stats_;
+        }
+
+        [[nodiscard]] auto stats() noexcept -> parse_stats& {
+            return stats_;
+        }
+
+    private:
+        static constexpr uint64_t sample_rate = 16;
+
+        parse_stats stats_;
+        uint64_t depth_ = 0;
+        uint64_t start_ = 0;
+#else
+        auto begin() noexcept -> void {}
+        auto finish(size_t) noexcept -> void {}
+        [[nodiscard]] auto time(uint64_t parse_stats::*) noexcept -> no_timer { return {}; }
+        [[nodiscard]] auto sample(uint64_t parse_stats::*) noexcept -> no_timer { return {}; }
+        auto count(uint64_t parse_stats::*) noexcept -> void {}
+        auto enter(uint64_t parse_stats::*) noexcept -> void {}
+        auto leave() noexcept -> void {}
+        auto allocated(size_t, size_t = 1) noexcept -> void {}
+
+        [[nodiscard]] auto stats() const noexcept -> parse_stats {
+            return {};
+        }
+#endif
+    };
+
+    class serialize_recorder {
+    public:
+#if JSONPP_DETAIL_STATS
+        auto begin() noexcept -> void {
+            stats_ = {};
+            start_ = now_ns();
+        }
+
+        auto finish(size_t bytes) noexcept -> void {
+            stats_.documents = 1;
+            stats_.bytes_written = bytes;
+            stats_.total_ns = now_ns() - start_;
+            global_stats().add(stats_);
+        }
+
+        auto count_value() noexcept -> void {
+            ++stats_.values;
+        }
+
+        [[nodiscard]] auto stats() const noexcept -> const serialize_stats& {
+            return stats_;
+        }
+
+    private:
+        serialize_stats stats_;
+        uint64_t start_ = 0;
+#else
+        auto begin() noexcept -> void {}
+        auto finish(size_t) noexcept -> void {}
+        auto count_value() noexcept -> void {}
+
+        [[nodiscard]] auto stats() const noexcept -> serialize_stats {
+            return {};
+        }
+#endif
+    };
+
+}
+
+}
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <optional>
+#include "json_value.hpp"
+#include "json_parser.hpp"
+#include "json_exception.hpp"
+#include "json_simd.hpp"
+
+namespace jsonpp {
+
+enum class stream_mode {
+    // A sequence of whitespace-separated top-level values.
+    values,
+    // A single top-level array whose elements are yielded one by one.
+    array_elements
+};
+
+// Push-style parser for input that arrives in chunks. Bytes are buffered only
+// until the value they belong to is complete, so memory is bounded by the
+// largest element rather than by the whole stream. Chunks may split any token.
+class stream_parser {
+public:
+    explicit stream_parser(stream_mode mode = stream_mode::values, parse_options options = {})
+        : mode_{ mode }, options_{ options } {
+        // The buffer is reused, so views into it cannot be handed out.
+        options_.borrow_strings = false;
+        state_ = mode_ == stream_mode::array_elements ? state::expect_open : state::between;
+    }
+
+    auto feed(std::string_view chunk) -> void {
+        buffer_.append(chunk);
+        scan();
+        compact();
+    }
+
+    // Signals the end of input, completing a trailing top-level number or
+    // literal and checking that nothing is left half-parsed.
+    auto finish() -> void {
+        if (state_ == state::in_element) {
+            if (kind_ != element_kind::scalar) {
+                throw parse_exception{"Unexpected end of input", consumed_ + buffer_.size()};
+            }
+            complete_element(buffer_.size());
+        }
+        if (mode_ == stream_mode::array_elements && state_ != state::done) {
+            throw parse_exception{"Unterminated array", consumed_ + buffer_.size()};
+        }
+        compact();
+    }
+
+    [[nodiscard]] auto next() -> std::optional<value> {
+        if (ready_.empty()) {
+            return std::nullopt;
+        }
+        auto result = std::move(ready_.front());
+        ready_.pop_front();
+        return result;
+    }
+
+    [[nodiscard]] auto available() const noexcept -> size_t {
+        return ready_.size();
+    }
+
+    [[nodiscard]] auto buffered_bytes() const noexcept -> size_t {
+        return buffer_.size();
+    }
+
+    auto reset() -> void {
+        buffer_.clear();
+        ready_.clear();
+        consumed_ = 0;
+        scan_ = 0;
+        start_ = 0;
+        depth_ = 0;
+        in_string_ = false;
+        escape_ = false;
+        state_ = mode_ == stream_mode::array_elements ? state::expect_open : state::between;
+    }
+
+private:
+    enum class state {
+        between,
+        expect_open,
+        expect_first,
+        expect_element,
+        expect_separator,
+        in_element,
+        done
+    };
+
+    enum class element_kind {
+        container,
+        string,
+        scalar
+    };
+
+    stream_mode mode_;
+    parse_options options_;
+    state state_;
+    element_kind kind_{ element_kind::scalar };
+
+    std::string buffer_;
+    std::deque<value> ready_;
+    size_t consumed_ = 0;
+    size_t scan_ = 0;
+    size_t start_ = 0;
+    size_t depth_ = 0;
+    bool in_string_ = false;
+    bool escape_ = false;
+
+    [[nodiscard]] auto offset(size_t position) const noexcept -> size_t {
+        return consumed_ + position;
+    }
+
+    [[nodiscard]] static auto ends_scalar(char ch) noexcept -> bool {
+        return is_whitespace(ch) || ch == ',' || ch == ']' || ch == '}' ||
+               ch == '[' || ch == '{' || ch == ':' || ch == '"';
+    }
+
+    auto scan() -> void {
+        while (scan_ < buffer_.size()) {
+            if (state_ == state::in_element) {
+                if (!scan_element()) {
+                    return;
+                }
+                continue;
+            }
+
+            const char ch = buffer_[scan_];
+            if (is_whitespace(ch)) {
+                ++scan_;
+                continue;
+            }
+
+            switch (state_) {
+                case state::expect_open:
+                    if (ch != '[') {
+                        throw parse_exception{
+                            std::format("Expected '[', got '{}'", ch), offset(scan_)
+                        };
+                    }
+                    state_ = state::expect_first;
+                    ++scan_;
+                    break;
+
+                case state::expect_first:
+                    if (ch == ']') {
+                        state_ = state::done;
+                        ++scan_;
+                    } else {
+                        begin_element(ch);
+                    }
+                    break;
+
+                case state::expect_element:
+                    if (ch == ']') {
+                        throw parse_exception{"Trailing comma in array", offset(scan_)};
+                    }
+                    begin_element(ch);
+                    break;
+
+                case state::expect_separator:
+                    if (ch == ',') {
+                        state_ = state::expect_element;
+                    } else if (ch == ']') {
+                        state_ = state::done;
+                    } else {
+                        throw parse_exception{
+                            std::format("Expected ',' or ']', got '{}'", ch), offset(scan_)
+                        };
+                    }
+                    ++scan_;
+                    break;
+
+                case state::between:
+                    begin_element(ch);
+                    break;
+
+                case state::done:
+                    throw parse_exception{"Unexpected characters after JSON value", offset(scan_)};
+
+                case state::in_element:
+                    break;
+            }
+        }
+    }
+
+    auto begin_element(char ch) -> void {
+        start_ = scan_;
+        depth_ = 0;
+        in_string_ = false;
+        escape_ = false;
+        state_ = state::in_element;
+
+        if (ch == '{' || ch == '[') {
+            kind_ = element_kind::container;
+        } else if (ch == '"') {
+            kind_ = element_kind::string;
+            in_string_ = true;
+            ++scan_;
+        } else if (ch == ']' || ch == '}' || ch == ',' || ch == ':') {
+            throw parse_exception{std::format("Unexpected character '{}'", ch), offset(scan_)};
+        } else {
+            kind_ = element_kind::scalar;
+            ++scan_;
+        }
+    }
+
+    // Advances through the current element; returns false when more input is
+    // needed to complete it.
+    auto scan_element() -> bool {
+        while (scan_ < buffer_.size()) {
+            if (kind_ == element_kind::scalar) {
+                if (ends_scalar(buffer_[scan_])) {
+                    complete_element(scan_);
+                    return true;
+                }
+                ++scan_;
+                continue;
+            }
+
+            if (in_string_) {
+                if (escape_) {
+                    escape_ = false;
+                    ++scan_;
+                    continue;
+                }
+                scan_ += detail::plain_string_run(buffer_.data() + scan_, buffer_.size() - scan_);
+                if (scan_ >= buffer_.size()) {
+                    return false;
+                }
+                const char ch = buffer_[scan_++];
+                if (ch == '\\') {
+                    escape_ = true;
+                } else if (ch == '"') {
+                    in_string_ = false;
+                    if (kind_ == element_kind::string) {
+                        complete_element(scan_);
+                        return true;
+                    }
+                }
+                continue;
+            }
+
+            const char ch = buffer_[scan_++];
+            if (ch == '"') {
+                in_string_ = true;
+            } else if (ch == '{' || ch == '[') {
+                ++depth_;
+            } else if (ch == '}' || ch == ']') {
+                if (--depth_ == 0) {
+                    complete_element(scan_);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // A malformed element is dropped before its error is thrown, positioned
+    // in the whole stream, so feeding can carry on after it.
+    auto complete_element(size_t end) -> void {
+        parser p{ std::string_view{ buffer_ }.substr(start_, end - start_), options_ };
+        auto result = p.try_parse();
+        const size_t element_offset = offset(start_);
+        scan_ = end;
+        start_ = end;
+        state_ = mode_ == stream_mode::array_elements ? state::expect_separator : state::between;
+        if (!result) {
+            parse_error error = result.error();
+            error.offset += element_offset;
+            throw parse_exception{ error };
+        }
+        ready_.push_back(std::move(*result));
+    }
+
+    // Drops everything before the element currently being scanned.
+    auto compact() -> void {
+        if (state_ != state::in_element) {
+            start_ = scan_;
+        }
+        const size_t keep_from = start_;
+        if (keep_from == 0) {
+            return;
+        }
+        buffer_.erase(0, keep_from);
+        consumed_ += keep_from;
+        scan_ -= keep_from;
+        start_ -= keep_from;
+    }
+};
+
+}
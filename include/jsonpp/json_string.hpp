@@ -0,0 +1,245 @@
+#pragma once
+
+#include <string_view>
+#include <memory_resource>
+#include <compare>
+#include <cstring>
+#include <cstdint>
+#include <new>
+#include <cstddef>
+#include <functional>
+
+namespace jsonpp {
+
+namespace detail {
+
+    // Out-of-line string storage: a header followed by the bytes, allocated
+    // in one piece from the resource it remembers for deallocation.
+    struct string_block {
+        std::pmr::memory_resource* resource;
+        size_t size;
+
+        [[nodiscard]] auto data() const noexcept -> const char* {
+            return reinterpret_cast<const char*>(this + 1);
+        }
+
+        [[nodiscard]] auto view() const noexcept -> std::string_view {
+            return { data(), size };
+        }
+
+        [[nodiscard]] static auto create(std::string_view text, std::pmr::memory_resource* resource) -> string_block* {
+            void* storage = resource->allocate(sizeof(string_block) + text.size(), alignof(string_block));
+            auto* block = ::new (storage) string_block{ resource, text.size() };
+            if (!text.empty()) {
+                std::memcpy(reinterpret_cast<char*>(block + 1), text.data(), text.size());
+            }
+            return block;
+        }
+
+        static auto destroy(string_block* block) noexcept -> void {
+            block->resource->deallocate(block, sizeof(string_block) + block->size, alignof(string_block));
+        }
+    };
+
+    // A key owned by a key_table: its hash, then a string_block whose
+    // resource is the table's arena and so identifies the table.
+    struct interned_block {
+        size_t hash;
+        string_block block;
+    };
+
+    static_assert(offsetof(interned_block, block) + sizeof(string_block) == sizeof(interned_block),
+                  "interned key bytes must follow the block directly");
+
+}
+
+// 16-byte string used for object keys. Up to 15 bytes are stored inline;
+// longer keys live in a string_block from the allocator's resource. Short
+// keys, the common case, therefore cost no allocation at all. A key from a
+// key_table is a borrowed pointer instead, copied without allocating and
+// compared to keys of the same table by address.
+class compact_string {
+public:
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    static constexpr size_t inline_capacity = 15;
+
+    compact_string() noexcept {
+        set_inline_size(0);
+    }
+
+    compact_string(std::string_view text, const allocator_type& alloc = {}) {
+        assign(text, alloc.resource());
+    }
+
+    compact_string(const char* text, const allocator_type& alloc = {})
+        : compact_string(std::string_view{ text }, alloc) {}
+
+    compact_string(const compact_string& other) {
+        copy_from(other, std::pmr::get_default_resource());
+    }
+
+    compact_string(const compact_string& other, const allocator_type& alloc) {
+        copy_from(other, alloc.resource());
+    }
+
+    compact_string(compact_string&& other) noexcept {
+        steal(other);
+    }
+
+    compact_string(compact_string&& other, const allocator_type& alloc) {
+        if (other.is_heap() && !other.block()->resource->is_equal(*alloc.resource())) {
+            assign(other.view(), alloc.resource());
+        } else {
+            steal(other);
+        }
+    }
+
+    auto operator=(const compact_string& other) -> compact_string& {
+        if (this != &other) {
+            std::pmr::memory_resource* resource = is_heap() ? block()->resource : std::pmr::get_default_resource();
+            compact_string copy{ other, resource };
+            release();
+            steal(copy);
+        }
+        return *this;
+    }
+
+    auto operator=(compact_string&& other) noexcept -> compact_string& {
+        if (this != &other) {
+            release();
+            steal(other);
+        }
+        return *this;
+    }
+
+    ~compact_string() {
+        release();
+    }
+
+    [[nodiscard]] auto data() const noexcept -> const char* {
+        return is_pointer() ? block()->data() : storage_;
+    }
+
+    [[nodiscard]] auto size() const noexcept -> size_t {
+        return is_pointer() ? block()->size : inline_capacity - static_cast<uint8_t>(storage_[inline_capacity]);
+    }
+
+    [[nodiscard]] auto empty() const noexcept -> bool {
+        return size() == 0;
+    }
+
+    [[nodiscard]] auto view() const noexcept -> std::string_view {
+        return { data(), size() };
+    }
+
+    operator std::string_view() const noexcept {
+        return view();
+    }
+
+    [[nodiscard]] auto is_interned() const noexcept -> bool {
+        return static_cast<uint8_t>(storage_[inline_capacity]) == interned_marker;
+    }
+
+    // Same value as std::hash<std::string_view> of the text; interned keys
+    // have it precomputed.
+    [[nodiscard]] auto hash() const noexcept -> size_t {
+        return is_interned() ? interned()->hash : std::hash<std::string_view>{}(view());
+    }
+
+    friend auto operator==(const compact_string& lhs, const compact_string& rhs) noexcept -> bool {
+        // One table never holds two copies of a text, so keys of the same
+        // table are equal exactly when they are the same entry.
+        if (lhs.is_interned() && rhs.is_interned() && lhs.block()->resource == rhs.block()->resource) {
+            return lhs.block() == rhs.block();
+        }
+        return lhs.view() == rhs.view();
+    }
+
+    friend auto operator==(const compact_string& lhs, std::string_view rhs) noexcept -> bool {
+        return lhs.view() == rhs;
+    }
+
+    friend auto operator<=>(const compact_string& lhs, const compact_string& rhs) noexcept -> std::strong_ordering {
+        return lhs.view() <=> rhs.view();
+    }
+
+    friend auto operator<=>(const compact_string& lhs, std::string_view rhs) noexcept -> std::strong_ordering {
+        return lhs.view() <=> rhs;
+    }
+
+private:
+    friend class key_table;
+
+    static constexpr uint8_t heap_marker = 0x80;
+    static constexpr uint8_t interned_marker = 0x81;
+
+    // Bytes 0-14 hold an inline string; byte 15 holds inline_capacity minus
+    // its size, heap_marker when bytes 0-7 point to an owned string_block,
+    // or interned_marker when they point into a key_table.
+    alignas(8) char storage_[16];
+
+    explicit compact_string(const detail::interned_block* entry) noexcept {
+        const detail::string_block* target = &entry->block;
+        std::memcpy(storage_, &target, sizeof(target));
+        storage_[inline_capacity] = static_cast<char>(interned_marker);
+    }
+
+    [[nodiscard]] auto is_heap() const noexcept -> bool {
+        return static_cast<uint8_t>(storage_[inline_capacity]) == heap_marker;
+    }
+
+    [[nodiscard]] auto is_pointer() const noexcept -> bool {
+        return (static_cast<uint8_t>(storage_[inline_capacity]) & heap_marker) != 0;
+    }
+
+    [[nodiscard]] auto interned() const noexcept -> const detail::interned_block* {
+        return reinterpret_cast<const detail::interned_block*>(
+            reinterpret_cast<const char*>(block()) - offsetof(detail::interned_block, block));
+    }
+
+    [[nodiscard]] auto block() const noexcept -> detail::string_block* {
+        detail::string_block* result;
+        std::memcpy(&result, storage_, sizeof(result));
+        return result;
+    }
+
+    auto set_inline_size(size_t size) noexcept -> void {
+        storage_[inline_capacity] = static_cast<char>(inline_capacity - size);
+    }
+
+    auto assign(std::string_view text, std::pmr::memory_resource* resource) -> void {
+        if (text.size() <= inline_capacity) {
+            if (!text.empty()) {
+                std::memcpy(storage_, text.data(), text.size());
+            }
+            set_inline_size(text.size());
+            return;
+        }
+        auto* created = detail::string_block::create(text, resource);
+        std::memcpy(storage_, &created, sizeof(created));
+        storage_[inline_capacity] = static_cast<char>(heap_marker);
+    }
+
+    auto copy_from(const compact_string& other, std::pmr::memory_resource* resource) -> void {
+        if (other.is_interned()) {
+            std::memcpy(storage_, other.storage_, sizeof(storage_));
+        } else {
+            assign(other.view(), resource);
+        }
+    }
+
+    auto steal(compact_string& other) noexcept -> void {
+        std::memcpy(storage_, other.storage_, sizeof(storage_));
+        other.set_inline_size(0);
+    }
+
+    auto release() noexcept -> void {
+        if (is_heap()) {
+            detail::string_block::destroy(block());
+            set_inline_size(0);
+        }
+    }
+};
+
+}
@@ -0,0 +1,366 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <array>
+#include <utility>
+#include <type_traits>
+#include <memory_resource>
+#include <algorithm>
+#include <format>
+#include <charconv>
+#include <system_error>
+#include "json_value.hpp"
+#include "json_parser.hpp"
+#include "json_describe.hpp"
+#include "json_exception.hpp"
+
+namespace jsonpp {
+
+namespace detail {
+
+    // Handler for the typed decoder. Scalars are kept until the decoder
+    // reads them back; while a jsonpp::value member is being decoded every
+    // event goes to a dom_builder instead.
+    class struct_events {
+    public:
+        enum class kind { none, null, boolean, integer, number, string };
+
+        kind last = kind::none;
+        bool boolean = false;
+        integer_type integer = 0;
+        number_type number = 0;
+
+        auto forward_to(dom_builder* builder) noexcept -> void {
+            builder_ = builder;
+        }
+
+        auto on_null() -> void {
+            if (builder_) { builder_->on_null(); return; }
+            last = kind::null;
+        }
+
+        auto on_bool(bool b) -> void {
+            if (builder_) { builder_->on_bool(b); return; }
+            last = kind::boolean;
+            boolean = b;
+        }
+
+        auto on_int(integer_type i) -> void {
+            if (builder_) { builder_->on_int(i); return; }
+            last = kind::integer;
+            integer = i;
+        }
+
+        auto on_double(number_type n) -> void {
+            if (builder_) { builder_->on_double(n); return; }
+            last = kind::number;
+            number = n;
+        }
+
+        auto on_string(std::string_view text) -> void {
+            if (builder_) { builder_->on_string(text); return; }
+            last = kind::string;
+        }
+
+        auto on_key(std::string_view text) -> void {
+            if (builder_) { builder_->on_key(text); }
+        }
+
+        auto start_object() -> void {
+            if (builder_) { builder_->start_object(); }
+        }
+
+        auto end_object(size_t count) -> void {
+            if (builder_) { builder_->end_object(count); }
+        }
+
+        auto start_array() -> void {
+            if (builder_) { builder_->start_array(); }
+        }
+
+        auto end_array(size_t count) -> void {
+            if (builder_) { builder_->end_array(count); }
+        }
+
+    private:
+        dom_builder* builder_ = nullptr;
+    };
+
+    // The key of member I of T as it appears in the input, quotes included,
+    // so an expected key is recognised by one fixed-size comparison.
+    template <described T, size_t I>
+    inline constexpr auto quoted_key = [] {
+        constexpr std::string_view name = field_table<T>::names[I];
+        std::array<char, name.size() + 2> result{};
+        result.front() = '"';
+        std::ranges::copy(name, result.begin() + 1);
+        result.back() = '"';
+        return result;
+    }();
+
+    template <described T>
+    inline constexpr auto required_members = std::apply([](const auto&... field) {
+        return std::array<bool, sizeof...(field)>{
+            !is_optional_v<typename std::remove_cvref_t<decltype(field)>::member_type>...
+        };
+    }, field_table<T>::fields);
+
+    // Decodes JSON text straight into a described type. Members are expected
+    // in declaration order: the next one is tried first by comparing its
+    // quoted name against the input, and only keys that miss, are escaped or
+    // are unknown go through string decoding and the compile-time
+    // field_table. Unknown members are validated and skipped. Missing members
+    // keep their default value unless parse_options::require_members is set.
+    class struct_decoder {
+    public:
+        struct_decoder(std::string_view input, const parse_options& options) noexcept
+            : input_{ input }, options_{ options }, reader_{ input, events_, options } {}
+
+        template <typename T>
+        [[nodiscard]] auto decode() -> T {
+            T result{};
+            reader_.start();
+            read(result);
+            reader_.finish();
+            return result;
+        }
+
+    private:
+        std::string_view input_;
+        parse_options options_;
+        struct_events events_;
+        basic_parser<struct_events> reader_;
+
+        template <typename T>
+        auto read(T& out) -> void {
+            if constexpr (std::is_same_v<T, value>) {
+                dom_builder builder{ input_, std::pmr::get_default_resource(), options_.borrow_strings, options_.keys };
+                events_.forward_to(&builder);
+                reader_.read_value();
+                events_.forward_to(nullptr);
+                out = builder.release();
+            } else if constexpr (is_optional_v<T>) {
+                if (reader_.peek_token() == 'n') {
+                    reader_.read_value();
+                    out.reset();
+                } else {
+                    read(out.emplace());
+                }
+            } else if constexpr (std::is_same_v<T, bool>) {
+                const char ch = reader_.peek_token();
+                if (ch != 't' && ch != 'f') {
+                    throw parse_exception{"Expected a boolean", reader_.position()};
+                }
+                reader_.read_value();
+                out = events_.boolean;
+            } else if constexpr (std::is_integral_v<T>) {
+                if constexpr (std::is_unsigned_v<T>) {
+                    if (read_unsigned(out)) {
+                        return;
+                    }
+                }
+                const size_t start = read_number();
+                if (events_.last != struct_events::kind::integer) {
+                    throw parse_exception{"Expected an integer", start};
+                }
+                if (!std::in_range<T>(events_.integer)) {
+                    throw parse_exception{"Integer out of range", start};
+                }
+                out = static_cast<T>(events_.integer);
+            } else if constexpr (std::is_floating_point_v<T>) {
+                const size_t start = read_number();
+                if (events_.last == struct_events::kind::integer) {
+                    out = static_cast<T>(events_.integer);
+                } else if (events_.last == struct_events::kind::number) {
+                    out = static_cast<T>(events_.number);
+                } else {
+                    throw parse_exception{"Expected a number", start};
+                }
+            } else if constexpr (std::is_assignable_v<T&, std::string_view> && !std::is_same_v<T, std::string_view>) {
+                if (reader_.peek_token() != '"') {
+                    throw parse_exception{"Expected a string", reader_.position()};
+                }
+                out = reader_.read_string();
+            } else if constexpr (described<T>) {
+                read_struct(out);
+            } else if constexpr (requires { out.clear(); out.push_back(typename T::value_type{}); }) {
+                read_array(out);
+            } else {
+                static_assert(sizeof(T) == 0, "Member type cannot be decoded");
+            }
+        }
+
+        // Reads a number token; returns its offset for error reporting.
+        auto read_number() -> size_t {
+            const char ch = reader_.peek_token();
+            const size_t start = reader_.position();
+            if (ch != '-' && (ch < '0' || ch > '9')) {
+                throw parse_exception{"Expected a number", start};
+            }
+            events_.last = struct_events::kind::none;
+            reader_.read_value();
+            return start;
+        }
+
+        // Reads a plain unsigned integer token straight from its digits, so
+        // values above INT64_MAX, which integer_type cannot hold, still fit.
+        // Anything else, such as a sign, a fraction or an exponent, returns
+        // false and is reported by the signed path.
+        template <typename T>
+        [[nodiscard]] auto read_unsigned(T& out) -> bool {
+            (void)reader_.peek_token();
+            const size_t start = reader_.position();
+            const char* const first = input_.data() + start;
+            const char* const last = input_.data() + input_.size();
+            T result{};
+            const auto [end, ec] = std::from_chars(first, last, result);
+            if (end == first || (*first == '0' && end - first > 1) ||
+                (end != last && (*end == '.' || *end == 'e' || *end == 'E'))) {
+                return false;
+            }
+            if (ec == std::errc::result_out_of_range) {
+                throw parse_exception{"Integer out of range", start};
+            }
+            (void)reader_.match(std::string_view{ first, static_cast<size_t>(end - first) });
+            out = result;
+            return true;
+        }
+
+        template <typename T>
+        auto read_array(T& out) -> void {
+            if (reader_.peek_token() != '[') {
+                throw parse_exception{"Expected an array", reader_.position()};
+            }
+            reader_.expect_token('[');
+            out.clear();
+
+            if (reader_.peek_token() == ']') {
+                reader_.expect_token(']');
+                return;
+            }
+
+            while (true) {
+                // Read into a local, as the element of a std::vector<bool>
+                // is only reachable through a proxy.
+                typename T::value_type element{};
+                read(element);
+                out.push_back(std::move(element));
+
+                const char ch = reader_.peek_token();
+                if (ch == ']') {
+                    reader_.expect_token(']');
+                    return;
+                }
+                if (ch != ',') {
+                    throw parse_exception{
+                        std::format("Expected ',' or ']', got '{}'", ch),
+                        reader_.position()
+                    };
+                }
+                reader_.expect_token(',');
+                if (reader_.peek_token() == ']') {
+                    throw parse_exception{"Trailing comma in array", reader_.position()};
+                }
+            }
+        }
+
+        template <typename T, size_t... I>
+        [[nodiscard]] static constexpr auto member_readers(std::index_sequence<I...>) {
+            return std::array<void (*)(struct_decoder&, T&), sizeof...(I)>{
+                [](struct_decoder& decoder, T& object) {
+                    decoder.read(object.*std::get<I>(field_table<T>::fields).pointer);
+                }...
+            };
+        }
+
+        template <typename T, size_t... I>
+        [[nodiscard]] static constexpr auto member_matchers(std::index_sequence<I...>) {
+            return std::array<bool (*)(basic_parser<struct_events>&), sizeof...(I)>{
+                [](basic_parser<struct_events>& reader) {
+                    constexpr const auto& key = quoted_key<T, I>;
+                    return reader.match(std::string_view{ key.data(), key.size() });
+                }...
+            };
+        }
+
+        template <typename T, size_t N>
+        auto check_required(const std::array<bool, N>& seen, size_t object_start) const -> void {
+            if (!options_.require_members) {
+                return;
+            }
+            for (size_t i = 0; i < N; ++i) {
+                if (required_members<T>[i] && !seen[i]) {
+                    throw parse_exception{
+                        std::format("Missing member '{}'", field_table<T>::names[i]),
+                        object_start
+                    };
+                }
+            }
+        }
+
+        template <typename T>
+        auto read_struct(T& out) -> void {
+            using table = field_table<T>;
+            static constexpr auto readers = member_readers<T>(std::make_index_sequence<table::size>{});
+            static constexpr auto matchers = member_matchers<T>(std::make_index_sequence<table::size>{});
+
+            if (reader_.peek_token() != '{') {
+                throw parse_exception{"Expected an object", reader_.position()};
+            }
+            const size_t object_start = reader_.position();
+            reader_.expect_token('{');
+            std::array<bool, table::size> seen{};
+
+            if (reader_.peek_token() == '}') {
+                reader_.expect_token('}');
+                check_required<T>(seen, object_start);
+                return;
+            }
+
+            size_t expected = 0;
+            while (true) {
+                size_t index;
+                if (expected < table::size && matchers[expected](reader_)) {
+                    index = expected;
+                } else {
+                    if (reader_.peek_token() != '"') {
+                        throw parse_exception{"Expected string key in object", reader_.position()};
+                    }
+                    index = table::lookup(reader_.read_string());
+                }
+                reader_.expect_token(':');
+
+                // A repeated member is skipped, so the first occurrence wins
+                // as it does when parsing into a value.
+                if (index < table::size && !seen[index]) {
+                    readers[index](*this, out);
+                    seen[index] = true;
+                    expected = index + 1;
+                } else {
+                    reader_.skip_value();
+                }
+
+                const char ch = reader_.peek_token();
+                if (ch == '}') {
+                    reader_.expect_token('}');
+                    check_required<T>(seen, object_start);
+                    return;
+                }
+                if (ch != ',') {
+                    throw parse_exception{
+                        std::format("Expected ',' or '}}', got '{}'", ch),
+                        reader_.position()
+                    };
+                }
+                reader_.expect_token(',');
+                if (reader_.peek_token() == '}') {
+                    throw parse_exception{"Trailing comma in object", reader_.position()};
+                }
+            }
+        }
+    };
+
+}
+
+}
@@ -0,0 +1,503 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <bit>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <span>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <format>
+#include <stdexcept>
+#include "json_value.hpp"
+#include "json_parser.hpp"
+#include "json_exception.hpp"
+
+namespace jsonpp {
+
+// Tag stored in the top byte of every tape word.
+enum class tape_tag : uint8_t {
+    null = 'n',
+    true_value = 't',
+    false_value = 'f',
+    integer = 'l',
+    number = 'd',
+    string = '"',
+    start_array = '[',
+    end_array = ']',
+    start_object = '{',
+    end_object = '}'
+};
+
+// Layout of a tape, one 64-bit word per token:
+//  - null, true, false: the tag alone;
+//  - integer, number: the tag, then a second word holding the raw bits;
+//  - string, object key: the tag and the offset of a 4-byte little-endian
+//    length followed by the bytes in the string buffer;
+//  - '[' and '{': the tag, the element count in bits 32-55 (saturated) and
+//    the index just past the matching close word in bits 0-31;
+//  - ']' and '}': the tag and the index of the matching open word.
+// Object members are a key word followed by the value's words.
+namespace tape {
+
+    inline constexpr uint64_t payload_mask = (uint64_t{ 1 } << 56) - 1;
+    inline constexpr uint64_t count_saturated = (uint64_t{ 1 } << 24) - 1;
+
+    [[nodiscard]] constexpr auto word(tape_tag tag, uint64_t payload = 0) noexcept -> uint64_t {
+        return uint64_t{ static_cast<uint8_t>(tag) } << 56 | (payload & payload_mask);
+    }
+
+    [[nodiscard]] constexpr auto tag_of(uint64_t word) noexcept -> tape_tag {
+        return static_cast<tape_tag>(word >> 56);
+    }
+
+    [[nodiscard]] constexpr auto payload_of(uint64_t word) noexcept -> uint64_t {
+        return word & payload_mask;
+    }
+
+}
+
+class tape_value;
+
+// Forward range over the elements of a tape array.
+class tape_array {
+public:
+    class iterator {
+    public:
+        using value_type = tape_value;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() noexcept = default;
+        iterator(const uint64_t* words, const char* strings, size_t index) noexcept
+            : words_{ words }, strings_{ strings }, index_{ index } {}
+
+        [[nodiscard]] auto operator*() const noexcept -> tape_value;
+        auto operator++() noexcept -> iterator&;
+        auto operator++(int) noexcept -> iterator {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        [[nodiscard]] auto operator==(const iterator& other) const noexcept -> bool {
+            return index_ == other.index_;
+        }
+
+    private:
+        const uint64_t* words_ = nullptr;
+        const char* strings_ = nullptr;
+        size_t index_ = 0;
+    };
+
+    tape_array(const uint64_t* words, const char* strings, size_t open) noexcept
+        : words_{ words }, strings_{ strings }, open_{ open } {}
+
+    [[nodiscard]] auto begin() const noexcept -> iterator {
+        return { words_, strings_, open_ + 1 };
+    }
+
+    [[nodiscard]] auto end() const noexcept -> iterator {
+        return { words_, strings_, static_cast<size_t>(words_[open_] & 0xFFFFFFFF) - 1 };
+    }
+
+private:
+    const uint64_t* words_;
+    const char* strings_;
+    size_t open_;
+};
+
+// Forward range over the members of a tape object, as (key, value) pairs.
+class tape_object {
+public:
+    class iterator {
+    public:
+        using value_type = std::pair<std::string_view, tape_value>;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() noexcept = default;
+        iterator(const uint64_t* words, const char* strings, size_t index) noexcept
+            : words_{ words }, strings_{ strings }, index_{ index } {}
+
+        [[nodiscard]] auto operator*() const noexcept -> value_type;
+        auto operator++() noexcept -> iterator&;
+        auto operator++(int) noexcept -> iterator {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        [[nodiscard]] auto operator==(const iterator& other) const noexcept -> bool {
+            return index_ == other.index_;
+        }
+
+    private:
+        const uint64_t* words_ = nullptr;
+        const char* strings_ = nullptr;
+        size_t index_ = 0;
+    };
+
+    tape_object(const uint64_t* words, const char* strings, size_t open) noexcept
+        : words_{ words }, strings_{ strings }, open_{ open } {}
+
+    [[nodiscard]] auto begin() const noexcept -> iterator {
+        return { words_, strings_, open_ + 1 };
+    }
+
+    [[nodiscard]] auto end() const noexcept -> iterator {
+        return { words_, strings_, static_cast<size_t>(words_[open_] & 0xFFFFFFFF) - 1 };
+    }
+
+private:
+    const uint64_t* words_;
+    const char* strings_;
+    size_t open_;
+};
+
+// Read-only view of one value on a tape, with the accessors of value. It is
+// two pointers and an index; the tape it refers to must outlive it.
+class tape_value {
+public:
+    tape_value(const uint64_t* words, const char* strings, size_t index) noexcept
+        : words_{ words }, strings_{ strings }, index_{ index } {}
+
+    [[nodiscard]] auto type() const noexcept -> value_type {
+        switch (tag()) {
+            case tape_tag::null: return value_type::null;
+            case tape_tag::true_value:
+            case tape_tag::false_value: return value_type::boolean;
+            case tape_tag::integer: return value_type::integer;
+            case tape_tag::number: return value_type::number;
+            case tape_tag::string: return value_type::string;
+            case tape_tag::start_array: return value_type::array;
+            default: return value_type::object;
+        }
+    }
+
+    [[nodiscard]] auto is_null() const noexcept -> bool { return tag() == tape_tag::null; }
+    [[nodiscard]] auto is_boolean() const noexcept -> bool {
+        return tag() == tape_tag::true_value || tag() == tape_tag::false_value;
+    }
+    [[nodiscard]] auto is_number() const noexcept -> bool { return tag() == tape_tag::number; }
+    [[nodiscard]] auto is_integer() const noexcept -> bool { return tag() == tape_tag::integer; }
+    [[nodiscard]] auto is_string() const noexcept -> bool { return tag() == tape_tag::string; }
+    [[nodiscard]] auto is_array() const noexcept -> bool { return tag() == tape_tag::start_array; }
+    [[nodiscard]] auto is_object() const noexcept -> bool { return tag() == tape_tag::start_object; }
+
+    [[nodiscard]] auto as_boolean() const -> boolean_type {
+        if (!is_boolean()) {
+            throw type_exception{"Value is not a boolean"};
+        }
+        return tag() == tape_tag::true_value;
+    }
+
+    [[nodiscard]] auto as_integer() const -> integer_type {
+        if (is_integer()) {
+            return static_cast<integer_type>(words_[index_ + 1]);
+        }
+        if (is_number()) {
+            return static_cast<integer_type>(std::bit_cast<number_type>(words_[index_ + 1]));
+        }
+        throw type_exception{"Value is not a number"};
+    }
+
+    [[nodiscard]] auto as_number() const -> number_type {
+        if (is_number()) {
+            return std::bit_cast<number_type>(words_[index_ + 1]);
+        }
+        if (is_integer()) {
+            return static_cast<number_type>(static_cast<integer_type>(words_[index_ + 1]));
+        }
+        throw type_exception{"Value is not a number"};
+    }
+
+    [[nodiscard]] auto as_string() const -> std::string_view {
+        if (!is_string()) {
+            throw type_exception{"Value is not a string"};
+        }
+        return string_at(index_);
+    }
+
+    [[nodiscard]] auto as_array() const -> tape_array {
+        if (!is_array()) {
+            throw type_exception{"Value is not an array"};
+        }
+        return { words_, strings_, index_ };
+    }
+
+    [[nodiscard]] auto as_object() const -> tape_object {
+        if (!is_object()) {
+            throw type_exception{"Value is not an object"};
+        }
+        return { words_, strings_, index_ };
+    }
+
+    [[nodiscard]] auto size() const -> size_t {
+        if (!is_array() && !is_object()) {
+            throw type_exception{"Value is not an array or object"};
+        }
+        const uint64_t count = (words_[index_] >> 32) & tape::count_saturated;
+        if (count < tape::count_saturated) {
+            return static_cast<size_t>(count);
+        }
+        size_t result = 0;
+        for (size_t i = index_ + 1, end = close(); i != end; i = next(i)) {
+            i = is_object() ? i + 1 : i;
+            ++result;
+        }
+        return result;
+    }
+
+    [[nodiscard]] auto empty() const -> bool {
+        return size() == 0;
+    }
+
+    [[nodiscard]] auto operator[](size_t index) const -> tape_value {
+        size_t position = as_array_start();
+        const size_t end = close();
+        for (size_t i = 0; i < index && position != end; ++i) {
+            position = next(position);
+        }
+        if (position == end) {
+            throw std::out_of_range{std::format("Index {} out of range", index)};
+        }
+        return { words_, strings_, position };
+    }
+
+    [[nodiscard]] auto contains(std::string_view key) const -> bool {
+        return is_object() && find(key) != npos;
+    }
+
+    [[nodiscard]] auto at(std::string_view key) const -> tape_value {
+        if (!is_object()) {
+            throw type_exception{"Value is not an object"};
+        }
+        const size_t position = find(key);
+        if (position == npos) {
+            throw std::out_of_range{std::format("Key '{}' not found", key)};
+        }
+        return { words_, strings_, position };
+    }
+
+    [[nodiscard]] auto operator[](std::string_view key) const -> tape_value {
+        return at(key);
+    }
+
+    // Copies this value and everything below it into a value tree.
+    [[nodiscard]] auto to_value() const -> value {
+        switch (tag()) {
+            case tape_tag::null: return value{};
+            case tape_tag::true_value: return value(true);
+            case tape_tag::false_value: return value(false);
+            case tape_tag::integer: return value(as_integer());
+            case tape_tag::number: return value(as_number());
+            case tape_tag::string: return value(as_string());
+            case tape_tag::start_array: {
+                array_type result;
+                result.reserve(size());
+                for (const auto element : as_array()) {
+                    result.push_back(element.to_value());
+                }
+                return value(std::move(result));
+            }
+            default: {
+                object_type result;
+                for (const auto [key, member] : as_object()) {
+                    result.try_emplace(key, member.to_value());
+                }
+                return value(std::move(result));
+            }
+        }
+    }
+
+    // Position of this value's first word on the tape.
+    [[nodiscard]] auto tape_index() const noexcept -> size_t {
+        return index_;
+    }
+
+private:
+    friend class tape_array;
+    friend class tape_object;
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    const uint64_t* words_;
+    const char* strings_;
+    size_t index_;
+
+    [[nodiscard]] auto tag() const noexcept -> tape_tag {
+        return tape::tag_of(words_[index_]);
+    }
+
+    [[nodiscard]] auto close() const noexcept -> size_t {
+        return static_cast<size_t>(words_[index_] & 0xFFFFFFFF) - 1;
+    }
+
+    [[nodiscard]] auto as_array_start() const -> size_t {
+        if (!is_array()) {
+            throw type_exception{"Value is not an array"};
+        }
+        return index_ + 1;
+    }
+
+    [[nodiscard]] auto string_at(size_t position) const noexcept -> std::string_view {
+        const char* entry = strings_ + tape::payload_of(words_[position]);
+        uint32_t length;
+        std::memcpy(&length, entry, sizeof(length));
+        if constexpr (std::endian::native == std::endian::big) {
+            length = std::byteswap(length);
+        }
+        return { entry + sizeof(length), length };
+    }
+
+    // Index of the word following the value that starts at position.
+    [[nodiscard]] auto next(size_t position) const noexcept -> size_t {
+        switch (tape::tag_of(words_[position])) {
+            case tape_tag::integer:
+            case tape_tag::number: return position + 2;
+            case tape_tag::start_array:
+            case tape_tag::start_object: return static_cast<size_t>(words_[position] & 0xFFFFFFFF);
+            default: return position + 1;
+        }
+    }
+
+    [[nodiscard]] auto find(std::string_view key) const noexcept -> size_t {
+        for (size_t i = index_ + 1, end = close(); i != end; i = next(i + 1)) {
+            if (string_at(i) == key) {
+                return i + 1;
+            }
+        }
+        return npos;
+    }
+};
+
+inline auto tape_array::iterator::operator*() const noexcept -> tape_value {
+    return { words_, strings_, index_ };
+}
+
+inline auto tape_array::iterator::operator++() noexcept -> iterator& {
+    index_ = tape_value{ words_, strings_, index_ }.next(index_);
+    return *this;
+}
+
+inline auto tape_object::iterator::operator*() const noexcept -> value_type {
+    return { tape_value{ words_, strings_, index_ }.string_at(index_), tape_value{ words_, strings_, index_ + 1 } };
+}
+
+inline auto tape_object::iterator::operator++() noexcept -> iterator& {
+    index_ = tape_value{ words_, strings_, index_ }.next(index_ + 1);
+    return *this;
+}
+
+// Writes parser events onto a tape.
+class tape_builder {
+public:
+    tape_builder(std::vector<uint64_t>& words, std::string& strings) noexcept
+        : words_{ words }, strings_{ strings } {}
+
+    auto on_null() -> void { words_.push_back(tape::word(tape_tag::null)); }
+
+    auto on_bool(bool b) -> void {
+        words_.push_back(tape::word(b ? tape_tag::true_value : tape_tag::false_value));
+    }
+
+    auto on_int(integer_type i) -> void {
+        words_.push_back(tape::word(tape_tag::integer));
+        words_.push_back(static_cast<uint64_t>(i));
+    }
+
+    auto on_double(number_type n) -> void {
+        words_.push_back(tape::word(tape_tag::number));
+        words_.push_back(std::bit_cast<uint64_t>(n));
+    }
+
+    auto on_string(std::string_view text) -> void {
+        if (text.size() > UINT32_MAX) {
+            throw json_exception{"String too long for a tape"};
+        }
+        words_.push_back(tape::word(tape_tag::string, strings_.size()));
+        auto length = static_cast<uint32_t>(text.size());
+        if constexpr (std::endian::native == std::endian::big) {
+            length = std::byteswap(length);
+        }
+        strings_.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        strings_.append(text);
+    }
+
+    auto on_key(std::string_view text) -> void {
+        on_string(text);
+    }
+
+    auto start_object() -> void { open(tape_tag::start_object); }
+    auto end_object(size_t count) -> void { close(tape_tag::end_object, count); }
+    auto start_array() -> void { open(tape_tag::start_array); }
+    auto end_array(size_t count) -> void { close(tape_tag::end_array, count); }
+
+private:
+    std::vector<uint64_t>& words_;
+    std::string& strings_;
+    std::vector<size_t> open_;
+
+    auto open(tape_tag tag) -> void {
+        open_.push_back(words_.size());
+        words_.push_back(tape::word(tag));
+    }
+
+    auto close(tape_tag tag, size_t count) -> void {
+        const size_t start = open_.back();
+        open_.pop_back();
+        words_.push_back(tape::word(tag, start));
+        if (words_.size() > UINT32_MAX) {
+            throw json_exception{"Document too large for a tape"};
+        }
+        const uint64_t saturated = std::min<uint64_t>(count, tape::count_saturated);
+        words_[start] = tape::word(tape::tag_of(words_[start]), saturated << 32 | words_.size());
+    }
+};
+
+// A parsed document stored as a tape: one contiguous array of words plus a
+// string buffer, laid out in document order and held in a few large
+// allocations. Read-only; navigate it through root().
+class tape_document {
+public:
+    tape_document() = default;
+
+    explicit tape_document(std::string_view text, const parse_options& options = {}) {
+        words_.reserve(text.size() / 8 + 16);
+        tape_builder builder{ words_, strings_ };
+        basic_parser<tape_builder> p{ text, builder, options };
+        p.parse();
+    }
+
+    // Adopts a tape assembled elsewhere, such as by parse_tape_parallel().
+    tape_document(std::vector<uint64_t> words, std::string strings) noexcept
+        : words_{ std::move(words) }, strings_{ std::move(strings) } {}
+
+    [[nodiscard]] auto root() const -> tape_value {
+        if (words_.empty()) {
+            throw json_exception{"Empty tape document"};
+        }
+        return { words_.data(), strings_.data(), 0 };
+    }
+
+    [[nodiscard]] auto tape() const noexcept -> std::span<const uint64_t> {
+        return words_;
+    }
+
+    [[nodiscard]] auto strings() const noexcept -> std::string_view {
+        return strings_;
+    }
+
+    // Bytes held by the tape and string buffer.
+    [[nodiscard]] auto memory_usage() const noexcept -> size_t {
+        return words_.capacity() * sizeof(uint64_t) + strings_.capacity();
+    }
+
+private:
+    std::vector<uint64_t> words_;
+    std::string strings_;
+};
+
+}
@@ -3,13 +3,23 @@
 #include <string>
 #include <string_view>
 #include <vector>
-#include <map>
 #include <variant>
 #include <memory>
 #include <concepts>
 #include <ranges>
 #include <optional>
+#include <compare>
+#include <cstring>
+#include <cstdint>
+#include <new>
+#include <memory_resource>
+#include <utility>
+#include <atomic>
+#include <bit>
+#include <functional>
 #include "json_exception.hpp"
+#include "json_object.hpp"
+#include "json_string.hpp"
 
 namespace jsonpp {
 
@@ -19,9 +29,10 @@ using null_type = std::monostate;
 using boolean_type = bool;
 using number_type = double;
 using integer_type = int64_t;
-using string_type = std::string;
-using array_type = std::vector<value>;
-using object_type = std::map<std::string, value, std::less<>>;
+using string_type = std::pmr::string;
+using array_type = std::pmr::vector<value>;
+using object_type = basic_object<compact_string, value>;
+using borrowed_string_type = std::string_view;
 
 enum class value_type {
     null,
@@ -33,187 +44,456 @@ enum class value_type {
     object
 };
 
+namespace detail {
+
+// MurmurHash3's 64-bit finalizer: every input bit affects every output bit.
+[[nodiscard]] constexpr auto hash_mix(uint64_t h) noexcept -> uint64_t {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Each kind mixes in its own constant, so null, false, 0, "" and [] differ.
+inline constexpr uint64_t hash_seed_null = 0x6a09e667f3bcc908ULL;
+inline constexpr uint64_t hash_seed_boolean = 0xbb67ae8584caa73bULL;
+inline constexpr uint64_t hash_seed_integer = 0x3c6ef372fe94f82bULL;
+inline constexpr uint64_t hash_seed_number = 0xa54ff53a5f1d36f1ULL;
+inline constexpr uint64_t hash_seed_string = 0x510e527fade682d1ULL;
+inline constexpr uint64_t hash_seed_array = 0x9b05688c2b3e6c1fULL;
+inline constexpr uint64_t hash_seed_object = 0x1f83d9abfb41bd6bULL;
+
+[[nodiscard]] constexpr auto hash_boolean(bool b) noexcept -> uint64_t {
+    return hash_mix(hash_seed_boolean + (b ? 1 : 0));
+}
+
+[[nodiscard]] constexpr auto hash_integer(int64_t i) noexcept -> uint64_t {
+    return hash_mix(hash_seed_integer ^ static_cast<uint64_t>(i));
+}
+
+// -0.0 == 0.0, so both hash alike.
+[[nodiscard]] inline auto hash_number(double n) noexcept -> uint64_t {
+    return hash_mix(hash_seed_number ^ std::bit_cast<uint64_t>(n == 0.0 ? 0.0 : n));
+}
+
+// Takes std::hash<std::string_view> of the text, which compact_string keys
+// already carry.
+[[nodiscard]] constexpr auto hash_string(size_t text_hash) noexcept -> uint64_t {
+    return hash_mix(hash_seed_string ^ static_cast<uint64_t>(text_hash));
+}
+
+[[nodiscard]] inline auto hash_string(std::string_view text) noexcept -> uint64_t {
+    return hash_string(std::hash<std::string_view>{}(text));
+}
+
+// Containers never hash to 0, which marks a hash not yet computed.
+[[nodiscard]] constexpr auto hash_nonzero(uint64_t h) noexcept -> uint64_t {
+    return h != 0 ? h : 1;
+}
+
+// Element order matters.
+struct array_hash {
+    uint64_t state = hash_seed_array;
+    uint64_t count = 0;
+
+    constexpr auto add(uint64_t element) noexcept -> void {
+        state = hash_mix(state + element + 0x9e3779b97f4a7c15ULL);
+        ++count;
+    }
+
+    [[nodiscard]] constexpr auto finish() const noexcept -> uint64_t {
+        return hash_nonzero(hash_mix(state ^ count));
+    }
+};
+
+// Members are summed, so their order does not matter, matching operator==.
+struct object_hash {
+    uint64_t sum = 0;
+    uint64_t count = 0;
+
+    constexpr auto add(size_t key_hash, uint64_t member) noexcept -> void {
+        sum += hash_mix(hash_string(key_hash) + member * 0x9e3779b97f4a7c15ULL);
+        ++count;
+    }
+
+    [[nodiscard]] constexpr auto finish() const noexcept -> uint64_t {
+        return hash_nonzero(hash_mix(hash_seed_object ^ sum ^ (count << 32)));
+    }
+};
+
+// Out-of-line storage of an array or object, alongside the hash of its
+// contents once computed.
+template <typename Container>
+struct container_node {
+    Container contents;
+    std::atomic<uint64_t> hash;
+
+    container_node(Container&& c, uint64_t h) noexcept
+        : contents(std::move(c)), hash{ h } {}
+};
+
+}
+
+// A 16-byte tagged union. Scalars and strings of up to 14 bytes are stored
+// inline; longer strings, arrays and objects live out of line, allocated
+// from the memory resource that owns their contents.
 class value {
 public:
+    // What get_variant() returns: a non-owning view of the current contents.
     using variant_type = std::variant<
         null_type,
         boolean_type,
-        integer_type,
         number_type,
-        string_type,
-        array_type,
-        object_type
+        integer_type,
+        std::string_view,
+        const array_type*,
+        const object_type*
     >;
 
-    value() noexcept = default;
+    static constexpr size_t inline_string_capacity = 14;
+
+    value() noexcept {
+        set_kind(kind::null);
+    }
+    
+    value(null_type) noexcept : value() {}
+
+    value(std::nullptr_t) noexcept : value() {}
     
-    value(null_type) noexcept : data_{null_type{}} {}
+    value(boolean_type b) noexcept {
+        store(b);
+        set_kind(kind::boolean);
+    }
     
-    value(boolean_type b) noexcept : data_{b} {}
+    value(integer_type i) noexcept {
+        store(i);
+        set_kind(kind::integer);
+    }
     
-    value(integer_type i) noexcept : data_{i} {}
+    value(int i) noexcept : value(static_cast<integer_type>(i)) {}
     
-    value(int i) noexcept : data_{static_cast<integer_type>(i)} {}
+    value(number_type n) noexcept {
+        store(n);
+        set_kind(kind::number);
+    }
     
-    value(number_type n) noexcept : data_{n} {}
+    value(const char* s) : value(std::string_view{ s }) {}
     
-    value(const char* s) : data_{string_type{s}} {}
+    value(const string_type& s) : value(std::string_view{ s }, s.get_allocator().resource()) {}
     
-    value(string_type s) : data_{std::move(s)} {}
+    value(const std::string& s) : value(std::string_view{ s }) {}
     
-    value(std::string_view s) : data_{string_type{s}} {}
+    value(std::string_view s) : value(s, std::pmr::get_default_resource()) {}
+
+    // Long strings are allocated from resource; short ones never allocate.
+    value(std::string_view s, std::pmr::memory_resource* resource) {
+        if (s.size() <= inline_string_capacity) {
+            if (!s.empty()) {
+                std::memcpy(storage_, s.data(), s.size());
+            }
+            storage_[inline_size_byte] = static_cast<unsigned char>(s.size());
+            set_kind(kind::short_string);
+        } else {
+            store(detail::string_block::create(s, resource));
+            set_kind(kind::long_string);
+        }
+    }
     
-    value(array_type arr) : data_{std::move(arr)} {}
+    value(array_type arr) {
+        store(create_node(std::move(arr)));
+        set_kind(kind::array);
+    }
     
-    value(object_type obj) : data_{std::move(obj)} {}
+    value(object_type obj) {
+        store(create_node(std::move(obj)));
+        set_kind(kind::object);
+    }
     
-    value(std::initializer_list<value> init) : data_{array_type{init}} {}
+    value(std::initializer_list<value> init) : value(array_type(init)) {}
     
-    value(std::initializer_list<std::pair<const std::string, value>> init) 
-        : data_{object_type{init}} {}
+    value(std::initializer_list<std::pair<std::string_view, value>> init) 
+        : value(object_type{}) {
+        auto& obj = as_object();
+        obj.reserve(init.size());
+        for (const auto& [key, val] : init) {
+            obj.emplace(key, val);
+        }
+    }
+
+    // Copies are deep and allocate from the default resource, as copying a
+    // pmr container does.
+    value(const value& other) {
+        switch (other.get_kind()) {
+            case kind::long_string:
+                store(detail::string_block::create(other.as_string(), std::pmr::get_default_resource()));
+                set_kind(kind::long_string);
+                break;
+            case kind::array:
+                store(create_node(array_type(*other.array_ptr()), other.array_node()->hash.load(std::memory_order_relaxed)));
+                set_kind(kind::array);
+                break;
+            case kind::object:
+                store(create_node(object_type(*other.object_ptr()), other.object_node()->hash.load(std::memory_order_relaxed)));
+                set_kind(kind::object);
+                break;
+            default:
+                std::memcpy(storage_, other.storage_, sizeof(storage_));
+                break;
+        }
+    }
+
+    // Every representation is a handful of bytes and pointers, so a move is
+    // a 16-byte copy that leaves other null.
+    value(value&& other) noexcept {
+        std::memcpy(storage_, other.storage_, sizeof(storage_));
+        other.set_kind(kind::null);
+    }
+
+    auto operator=(const value& other) -> value& {
+        if (this != &other) {
+            value copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    auto operator=(value&& other) noexcept -> value& {
+        if (this != &other) {
+            release();
+            std::memcpy(storage_, other.storage_, sizeof(storage_));
+            other.set_kind(kind::null);
+        }
+        return *this;
+    }
+
+    ~value() {
+        release();
+    }
+
+    // A string that points into memory owned by someone else, typically the
+    // parser input. The caller guarantees that memory outlives the value.
+    [[nodiscard]] static auto borrowed(borrowed_string_type s) noexcept -> value {
+        value result;
+        result.store(s.data());
+        for (size_t i = 0; i < borrowed_size_bytes; ++i) {
+            result.storage_[sizeof(const char*) + i] = static_cast<unsigned char>(s.size() >> (8 * i));
+        }
+        result.set_kind(kind::borrowed_string);
+        return result;
+    }
 
     [[nodiscard]] auto type() const noexcept -> value_type {
-        return static_cast<value_type>(data_.index());
+        switch (get_kind()) {
+            case kind::null: return value_type::null;
+            case kind::boolean: return value_type::boolean;
+            case kind::number: return value_type::number;
+            case kind::integer: return value_type::integer;
+            case kind::array: return value_type::array;
+            case kind::object: return value_type::object;
+            default: return value_type::string;
+        }
     }
     
     [[nodiscard]] auto is_null() const noexcept -> bool {
-        return std::holds_alternative<null_type>(data_);
+        return get_kind() == kind::null;
     }
     
     [[nodiscard]] auto is_boolean() const noexcept -> bool {
-        return std::holds_alternative<boolean_type>(data_);
+        return get_kind() == kind::boolean;
     }
     
     [[nodiscard]] auto is_number() const noexcept -> bool {
-        return std::holds_alternative<number_type>(data_);
+        return get_kind() == kind::number;
     }
     
     [[nodiscard]] auto is_integer() const noexcept -> bool {
-        return std::holds_alternative<integer_type>(data_);
+        return get_kind() == kind::integer;
     }
     
     [[nodiscard]] auto is_string() const noexcept -> bool {
-        return std::holds_alternative<string_type>(data_);
+        const kind k = get_kind();
+        return k == kind::short_string || k == kind::long_string || k == kind::borrowed_string;
+    }
+
+    [[nodiscard]] auto is_borrowed() const noexcept -> bool {
+        return get_kind() == kind::borrowed_string;
     }
     
     [[nodiscard]] auto is_array() const noexcept -> bool {
-        return std::holds_alternative<array_type>(data_);
+        return get_kind() == kind::array;
     }
     
     [[nodiscard]] auto is_object() const noexcept -> bool {
-        return std::holds_alternative<object_type>(data_);
+        return get_kind() == kind::object;
     }
 
     [[nodiscard]] auto as_boolean() const -> boolean_type {
         if (!is_boolean()) {
             throw type_exception{"Value is not a boolean"};
         }
-        return std::get<boolean_type>(data_);
+        return load<boolean_type>();
     }
     
     [[nodiscard]] auto as_integer() const -> integer_type {
         if (is_integer()) {
-            return std::get<integer_type>(data_);
+            return load<integer_type>();
         }
         if (is_number()) {
-            return static_cast<integer_type>(std::get<number_type>(data_));
+            return static_cast<integer_type>(load<number_type>());
         }
         throw type_exception{"Value is not a number"};
     }
     
     [[nodiscard]] auto as_number() const -> number_type {
         if (is_number()) {
-            return std::get<number_type>(data_);
+            return load<number_type>();
         }
         if (is_integer()) {
-            return static_cast<number_type>(std::get<integer_type>(data_));
+            return static_cast<number_type>(load<integer_type>());
         }
         throw type_exception{"Value is not a number"};
     }
     
-    [[nodiscard]] auto as_string() const -> const string_type& {
-        if (!is_string()) {
-            throw type_exception{"Value is not a string"};
+    [[nodiscard]] auto as_string() const -> std::string_view {
+        switch (get_kind()) {
+            case kind::short_string:
+                return { reinterpret_cast<const char*>(storage_), storage_[inline_size_byte] };
+            case kind::long_string:
+                return load<detail::string_block*>()->view();
+            case kind::borrowed_string: {
+                size_t size = 0;
+                for (size_t i = 0; i < borrowed_size_bytes; ++i) {
+                    size |= size_t{ storage_[sizeof(const char*) + i] } << (8 * i);
+                }
+                return { load<const char*>(), size };
+            }
+            default:
+                throw type_exception{"Value is not a string"};
         }
-        return std::get<string_type>(data_);
     }
     
     [[nodiscard]] auto as_array() const -> const array_type& {
         if (!is_array()) {
             throw type_exception{"Value is not an array"};
         }
-        return std::get<array_type>(data_);
+        return *array_ptr();
     }
     
     [[nodiscard]] auto as_array() -> array_type& {
         if (!is_array()) {
             throw type_exception{"Value is not an array"};
         }
-        return std::get<array_type>(data_);
+        array_node()->hash.store(0, std::memory_order_relaxed);
+        return *array_ptr();
     }
     
     [[nodiscard]] auto as_object() const -> const object_type& {
         if (!is_object()) {
             throw type_exception{"Value is not an object"};
         }
-        return std::get<object_type>(data_);
+        return *object_ptr();
     }
     
     [[nodiscard]] auto as_object() -> object_type& {
         if (!is_object()) {
             throw type_exception{"Value is not an object"};
         }
-        return std::get<object_type>(data_);
+        object_node()->hash.store(0, std::memory_order_relaxed);
+        return *object_ptr();
     }
 
     [[nodiscard]] auto size() const -> size_t {
         if (is_array()) {
-            return std::get<array_type>(data_).size();
+            return array_ptr()->size();
         }
         if (is_object()) {
-            return std::get<object_type>(data_).size();
+            return object_ptr()->size();
         }
         throw type_exception{"Value is not an array or object"};
     }
     
     [[nodiscard]] auto empty() const -> bool {
         if (is_array()) {
-            return std::get<array_type>(data_).empty();
+            return array_ptr()->empty();
         }
         if (is_object()) {
-            return std::get<object_type>(data_).empty();
+            return object_ptr()->empty();
         }
         throw type_exception{"Value is not an array or object"};
     }
     
     auto push_back(value val) -> void {
-        if (!is_array()) {
-            throw type_exception{"Value is not an array"};
+        as_array().push_back(std::move(val));
+    }
+
+    auto reserve(size_t count) -> void {
+        if (is_array()) {
+            array_ptr()->reserve(count);
+        } else if (is_object()) {
+            object_ptr()->reserve(count);
+        } else {
+            throw type_exception{"Value is not an array or object"};
+        }
+    }
+
+    template <typename... Args>
+    auto emplace_back(Args&&... args) -> value& {
+        return as_array().emplace_back(std::forward<Args>(args)...);
+    }
+
+    // Constructs the member from args only if key is absent; an existing
+    // member is left alone and args are not consumed.
+    template <typename... Args>
+    auto try_emplace(std::string_view key, Args&&... args) -> std::pair<object_type::iterator, bool> {
+        return as_object().try_emplace(key, std::forward<Args>(args)...);
+    }
+
+    template <typename V>
+    auto insert_or_assign(std::string_view key, V&& val) -> value& {
+        auto [it, inserted] = as_object().try_emplace(key, std::forward<V>(val));
+        if (!inserted) {
+            it->second = std::forward<V>(val);
+        }
+        return it->second;
+    }
+
+    // The member named key, or nullptr if there is none or this is not an
+    // object. Never allocates.
+    [[nodiscard]] auto find(std::string_view key) const -> const value* {
+        if (!is_object()) {
+            return nullptr;
         }
-        std::get<array_type>(data_).push_back(std::move(val));
+        const auto it = object_ptr()->find(key);
+        return it != object_ptr()->end() ? &it->second : nullptr;
+    }
+
+    [[nodiscard]] auto find(std::string_view key) -> value* {
+        if (!is_object()) {
+            return nullptr;
+        }
+        const auto it = as_object().find(key);
+        return it != object_ptr()->end() ? &it->second : nullptr;
     }
     
     [[nodiscard]] auto operator[](size_t index) const -> const value& {
-        return std::get<array_type>(data_)[index];
+        return as_array()[index];
     }
     
     [[nodiscard]] auto operator[](size_t index) -> value& {
-        return std::get<array_type>(data_)[index];
+        return as_array()[index];
     }
 
     [[nodiscard]] auto contains(std::string_view key) const -> bool {
         if (!is_object()) {
             return false;
         }
-        const auto& obj = std::get<object_type>(data_);
-        return obj.contains(key);
+        return object_ptr()->contains(key);
     }
     
     [[nodiscard]] auto at(std::string_view key) const -> const value& {
-        if (!is_object()) {
-            throw type_exception{"Value is not an object"};
-        }
-        const auto& obj = std::get<object_type>(data_);
+        const auto& obj = as_object();
         auto it = obj.find(key);
         if (it == obj.end()) {
             throw std::out_of_range{std::format("Key '{}' not found", key)};
@@ -222,10 +502,7 @@ public:
     }
     
     [[nodiscard]] auto at(std::string_view key) -> value& {
-        if (!is_object()) {
-            throw type_exception{"Value is not an object"};
-        }
-        auto& obj = std::get<object_type>(data_);
+        auto& obj = as_object();
         auto it = obj.find(key);
         if (it == obj.end()) {
             throw std::out_of_range{std::format("Key '{}' not found", key)};
@@ -234,21 +511,232 @@ public:
     }
     
     [[nodiscard]] auto operator[](std::string_view key) -> value& {
-        if (!is_object()) {
-            throw type_exception{"Value is not an object"};
+        return as_object()[key];
+    }
+
+    // A well-mixed 64-bit hash that agrees with operator==: strings hash by
+    // content whatever their representation, objects regardless of member
+    // order, and 1 differs from 1.0. Arrays and objects keep their hash
+    // until they are next reached through a non-const accessor, so after a
+    // write through a reference taken earlier an enclosing container's hash
+    // is stale. operator== never consults the cache and stays exact.
+    [[nodiscard]] auto hash() const noexcept -> uint64_t {
+        switch (get_kind()) {
+            case kind::null: return detail::hash_mix(detail::hash_seed_null);
+            case kind::boolean: return detail::hash_boolean(load<boolean_type>());
+            case kind::number: return detail::hash_number(load<number_type>());
+            case kind::integer: return detail::hash_integer(load<integer_type>());
+            case kind::array: return container_hash(array_node());
+            case kind::object: return container_hash(object_node());
+            default: return detail::hash_string(as_string());
         }
-        return std::get<object_type>(data_)[std::string{key}];
     }
 
-    [[nodiscard]] auto operator==(const value& other) const noexcept -> bool = default;
-    [[nodiscard]] auto operator<=>(const value& other) const noexcept = default;
+    [[nodiscard]] auto operator==(const value& other) const noexcept -> bool {
+        if (is_string() && other.is_string()) {
+            return as_string() == other.as_string();
+        }
+        if (get_kind() != other.get_kind()) {
+            return false;
+        }
+        switch (get_kind()) {
+            case kind::null: return true;
+            case kind::boolean: return load<boolean_type>() == other.load<boolean_type>();
+            case kind::number: return load<number_type>() == other.load<number_type>();
+            case kind::integer: return load<integer_type>() == other.load<integer_type>();
+            case kind::array:
+                return *array_ptr() == *other.array_ptr();
+            default:
+                return *object_ptr() == *other.object_ptr();
+        }
+    }
 
-    [[nodiscard]] auto get_variant() const noexcept -> const variant_type& {
-        return data_;
+    [[nodiscard]] auto operator<=>(const value& other) const noexcept -> std::partial_ordering {
+        if (is_string() && other.is_string()) {
+            return as_string() <=> other.as_string();
+        }
+        if (type() != other.type()) {
+            return type() <=> other.type();
+        }
+        switch (get_kind()) {
+            case kind::null: return std::partial_ordering::equivalent;
+            case kind::boolean: return load<boolean_type>() <=> other.load<boolean_type>();
+            case kind::number: return load<number_type>() <=> other.load<number_type>();
+            case kind::integer: return load<integer_type>() <=> other.load<integer_type>();
+            case kind::array: return *array_ptr() <=> *other.array_ptr();
+            default: return *object_ptr() <=> *other.object_ptr();
+        }
+    }
+
+    [[nodiscard]] auto get_variant() const noexcept -> variant_type {
+        switch (get_kind()) {
+            case kind::null: return null_type{};
+            case kind::boolean: return load<boolean_type>();
+            case kind::number: return load<number_type>();
+            case kind::integer: return load<integer_type>();
+            case kind::array: return array_ptr();
+            case kind::object: return object_ptr();
+            default: return as_string();
+        }
     }
 
 private:
-    variant_type data_{null_type{}};
+    enum class kind : unsigned char {
+        null,
+        boolean,
+        number,
+        integer,
+        short_string,
+        long_string,
+        borrowed_string,
+        array,
+        object
+    };
+
+    // Bytes 0-7 hold the payload: a scalar, a pointer, or the start of a
+    // short string. Byte 14 is a short string's length and bytes 8-13 a
+    // borrowed string's; byte 15 is the kind.
+    static constexpr size_t inline_size_byte = 14;
+    static constexpr size_t kind_byte = 15;
+    static constexpr size_t borrowed_size_bytes = 6;
+
+    alignas(8) unsigned char storage_[16];
+
+    [[nodiscard]] auto get_kind() const noexcept -> kind {
+        return static_cast<kind>(storage_[kind_byte]);
+    }
+
+    auto set_kind(kind k) noexcept -> void {
+        storage_[kind_byte] = static_cast<unsigned char>(k);
+    }
+
+    template <typename T>
+    [[nodiscard]] auto load() const noexcept -> T {
+        T result;
+        std::memcpy(&result, storage_, sizeof(T));
+        return result;
+    }
+
+    template <typename T>
+    auto store(T payload) noexcept -> void {
+        std::memcpy(storage_, &payload, sizeof(T));
+    }
+
+    using array_node_type = detail::container_node<array_type>;
+    using object_node_type = detail::container_node<object_type>;
+
+    [[nodiscard]] auto array_node() const noexcept -> array_node_type* {
+        return load<array_node_type*>();
+    }
+
+    [[nodiscard]] auto object_node() const noexcept -> object_node_type* {
+        return load<object_node_type*>();
+    }
+
+    [[nodiscard]] auto array_ptr() const noexcept -> array_type* {
+        return &array_node()->contents;
+    }
+
+    [[nodiscard]] auto object_ptr() const noexcept -> object_type* {
+        return &object_node()->contents;
+    }
+
+    // Computed at most once per modification; concurrent readers may both
+    // compute it, and store the same result.
+    template <typename Node>
+    [[nodiscard]] static auto container_hash(Node* node) noexcept -> uint64_t {
+        uint64_t h = node->hash.load(std::memory_order_relaxed);
+        if (h != 0) {
+            return h;
+        }
+        if constexpr (std::same_as<Node, array_node_type>) {
+            detail::array_hash state;
+            for (const auto& element : node->contents) {
+                state.add(element.hash());
+            }
+            h = state.finish();
+        } else {
+            detail::object_hash state;
+            for (const auto& [key, member] : node->contents) {
+                state.add(key.hash(), member.hash());
+            }
+            h = state.finish();
+        }
+        node->hash.store(h, std::memory_order_relaxed);
+        return h;
+    }
+
+    // Containers are placed in memory from their own allocator's resource,
+    // so a document's arena holds the nodes as well as their contents.
+    template <typename Container>
+    [[nodiscard]] static auto create_node(Container&& contents, uint64_t hash = 0)
+        -> detail::container_node<Container>* {
+        using node_type = detail::container_node<Container>;
+        std::pmr::memory_resource* resource = contents.get_allocator().resource();
+        void* storage = resource->allocate(sizeof(node_type), alignof(node_type));
+        return ::new (storage) node_type(std::move(contents), hash);
+    }
+
+    template <typename Node>
+    static auto destroy_node(Node* node) noexcept -> void {
+        std::pmr::memory_resource* resource = node->contents.get_allocator().resource();
+        node->~Node();
+        resource->deallocate(node, sizeof(Node), alignof(Node));
+    }
+
+    auto release() noexcept -> void {
+        switch (get_kind()) {
+            case kind::long_string: detail::string_block::destroy(load<detail::string_block*>()); break;
+            case kind::array: destroy_node(array_node()); break;
+            case kind::object: destroy_node(object_node()); break;
+            default: break;
+        }
+        set_kind(kind::null);
+    }
+};
+
+static_assert(sizeof(value) == 16);
+
+// A builder argument naming one member of make_object(). It only refers to
+// key and value, so it must be consumed within the same full expression.
+template <typename V>
+struct object_member {
+    std::string_view key;
+    V&& val;
 };
 
+template <typename V>
+[[nodiscard]] auto member(std::string_view key, V&& val) -> object_member<V> {
+    return { key, std::forward<V>(val) };
 }
+
+// Builds an array with its storage reserved up front, moving rvalue
+// elements in; unlike an initializer list, nothing is copied.
+template <typename... Elements>
+[[nodiscard]] auto make_array(Elements&&... elements) -> value {
+    value result(array_type{});
+    result.reserve(sizeof...(Elements));
+    (result.emplace_back(std::forward<Elements>(elements)), ...);
+    return result;
+}
+
+//     auto response = make_object(member("id", 42), member("tags", std::move(tags)));
+//
+// Reserves the members and their index once and moves rvalue values in.
+// A repeated key keeps its first value.
+template <typename... Values>
+[[nodiscard]] auto make_object(object_member<Values>... members) -> value {
+    value result(object_type{});
+    result.reserve(sizeof...(Values));
+    (result.try_emplace(members.key, std::forward<Values>(members.val)), ...);
+    return result;
+}
+
+}
+
+template <>
+struct std::hash<jsonpp::value> {
+    [[nodiscard]] auto operator()(const jsonpp::value& val) const noexcept -> size_t {
+        return static_cast<size_t>(val.hash());
+    }
+};
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cmath>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "json_value.hpp"
+#include "json_serializer.hpp"
+#include "json_describe.hpp"
+#include "json_exception.hpp"
+
+namespace jsonpp {
+
+// Writes compact JSON event by event into an output_buffer, such as a
+// std::string or a sink_buffer, without building a value:
+//
+//     writer out{ buffer };
+//     out.begin_object().key("id").value(42).key("tags").begin_array();
+//     out.value("a").value("b").end_array().end_object();
+//
+// Commas are inserted as needed and misuse, such as a value where a key is
+// due, throws json_exception. Consecutive top-level values are separated by
+// newlines, which makes a writer over a sink an NDJSON producer.
+template <output_buffer Buffer>
+class writer {
+public:
+    explicit writer(Buffer& out) noexcept
+        : out_{ out } {}
+
+    auto begin_object() -> writer& {
+        before_value();
+        out_.push_back('{');
+        frames_.push_back({ true, true });
+        return *this;
+    }
+
+    auto end_object() -> writer& {
+        if (frames_.empty() || !frames_.back().object || expecting_value_) {
+            throw json_exception{"end_object() does not close an object"};
+        }
+        frames_.pop_back();
+        out_.push_back('}');
+        return *this;
+    }
+
+    auto begin_array() -> writer& {
+        before_value();
+        out_.push_back('[');
+        frames_.push_back({ false, true });
+        return *this;
+    }
+
+    auto end_array() -> writer& {
+        if (frames_.empty() || frames_.back().object) {
+            throw json_exception{"end_array() does not close an array"};
+        }
+        frames_.pop_back();
+        out_.push_back(']');
+        return *this;
+    }
+
+    auto key(std::string_view name) -> writer& {
+        if (frames_.empty() || !frames_.back().object || expecting_value_) {
+            throw json_exception{"key() outside of an object or twice in a row"};
+        }
+        separate();
+        serializer::serialize_string(out_, name);
+        out_.push_back(':');
+        expecting_value_ = true;
+        return *this;
+    }
+
+    auto value(std::nullptr_t) -> writer& {
+        before_value();
+        serializer::write(out_, "null");
+        return *this;
+    }
+
+    auto value(bool b) -> writer& {
+        before_value();
+        serializer::write(out_, b ? "true" : "false");
+        return *this;
+    }
+
+    template <std::integral Integer>
+        requires (!std::same_as<Integer, bool>)
+    auto value(Integer number) -> writer& {
+        before_value();
+        serializer::serialize_integer(out_, number);
+        return *this;
+    }
+
+    template <std::floating_point Number>
+    auto value(Number number) -> writer& {
+        if (!std::isfinite(number)) {
+            throw json_exception{"Infinity and NaN have no JSON representation"};
+        }
+        before_value();
+        serializer::serialize_number(out_, number);
+        return *this;
+    }
+
+    auto value(std::string_view text) -> writer& {
+        before_value();
+        serializer::serialize_string(out_, text);
+        return *this;
+    }
+
+    auto value(const char* text) -> writer& {
+        return value(std::string_view{ text });
+    }
+
+    // Without it a std::string would convert equally well to string_view
+    // and to jsonpp::value.
+    auto value(const std::string& text) -> writer& {
+        return value(std::string_view{ text });
+    }
+
+    auto value(const jsonpp::value& tree) -> writer& {
+        before_value();
+        serializer{}.serialize_to(tree, out_);
+        return *this;
+    }
+
+    template <described T>
+    auto value(const T& object) -> writer& {
+        before_value();
+        serializer{}.serialize_to(object, out_);
+        return *this;
+    }
+
+    // Nesting depth of the containers still open.
+    [[nodiscard]] auto depth() const noexcept -> size_t {
+        return frames_.size();
+    }
+
+private:
+    struct frame {
+        bool object;
+        bool first;
+    };
+
+    Buffer& out_;
+    std::vector<frame> frames_;
+    bool expecting_value_ = false;
+    bool wrote_top_level_ = false;
+
+    auto separate() -> void {
+        if (!frames_.back().first) {
+            out_.push_back(',');
+        }
+        frames_.back().first = false;
+    }
+
+    auto before_value() -> void {
+        if (frames_.empty()) {
+            if (wrote_top_level_) {
+                out_.push_back('\n');
+            }
+            wrote_top_level_ = true;
+            return;
+        }
+        if (frames_.back().object) {
+            if (!expecting_value_) {
+                throw json_exception{"Object member needs a key() first"};
+            }
+            expecting_value_ = false;
+            return;
+        }
+        separate();
+    }
+};
+
+}
@@ -0,0 +1,68 @@
+#include <jsonpp/json.hpp>
+#include <iostream>
+
+namespace {
+
+int failures = 0;
+
+auto check(bool condition, const char* what) -> void {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << '\n';
+        ++failures;
+    }
+}
+
+// A failed parse_into() must not leave values from the document's arena in
+// the parser, where the next parse would destroy them after the arena.
+auto reusable_parser_after_failed_parse_into() -> void {
+    jsonpp::reusable_parser rp;
+    {
+        jsonpp::document doc;
+        bool threw = false;
+        try {
+            rp.parse_into(R"([{"a": [1, 2, {"b": "long enough to allocate"}], "c": tru)", doc);
+        } catch (const jsonpp::parse_exception&) {
+            threw = true;
+        }
+        check(threw, "parse_into rejects malformed input");
+    }
+    const auto result = rp.parse("[1,2,3]");
+    check(result.size() == 3, "reusable_parser parses after a failed parse_into");
+}
+
+// skip_value() continues from the depth the pull interface has reached,
+// so a skipped value cannot nest max_depth more levels.
+auto skip_value_counts_enclosing_depth() -> void {
+    jsonpp::null_handler handler;
+    jsonpp::parse_options options;
+    options.max_depth = 3;
+
+    jsonpp::basic_parser<jsonpp::null_handler> within{ "[[[1]], 2]", handler, options };
+    within.start();
+    within.expect_token('[');
+    within.skip_value();
+    within.expect_token(',');
+    within.skip_value();
+    within.expect_token(']');
+    within.finish();
+    check(within.position() == 10, "skip_value steps over values within max_depth");
+
+    jsonpp::basic_parser<jsonpp::null_handler> beyond{ "[[[[1]]]]", handler, options };
+    bool threw = false;
+    try {
+        beyond.start();
+        beyond.expect_token('[');
+        beyond.skip_value();
+    } catch (const jsonpp::parse_exception&) {
+        threw = true;
+    }
+    check(threw, "skip_value rejects a value nested beyond max_depth");
+}
+
+}
+
+auto main() -> int {
+    reusable_parser_after_failed_parse_into();
+    skip_value_counts_enclosing_depth();
+    return failures == 0 ? 0 : 1;
+}